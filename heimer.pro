@@ -24,10 +24,15 @@ INCLUDEPATH += . $$SRC/contrib/SimpleLogger/src $$SRC/contrib/Argengine/src
 # Input
 HEADERS +=  \
     $$SRC/about_dlg.hpp \
+    $$SRC/alz_journal.hpp \
     $$SRC/alz_serializer.hpp \
+    $$SRC/alzb_serializer.hpp \
     $$SRC/application.hpp \
+    $$SRC/autosave_manager.hpp \
+    $$SRC/compressing_device.hpp \
     $$SRC/copy_paste.hpp \
     $$SRC/defaults.hpp \
+    $$SRC/decompressing_device.hpp \
     $$SRC/defaults_dlg.hpp \
     $$SRC/graph.hpp \
     $$SRC/graphics_factory.hpp \
@@ -36,12 +41,16 @@ HEADERS +=  \
     $$SRC/edge_context_menu.hpp \
     $$SRC/edge_dot.hpp \
     $$SRC/edge_text_edit.hpp \
+    $$SRC/edge_update_scheduler.hpp \
     $$SRC/editor_data.hpp \
     $$SRC/editor_scene.hpp \
     $$SRC/editor_view.hpp \
     $$SRC/file_exception.hpp \
     $$SRC/hash_seed.hpp \
     $$SRC/image.hpp \
+    $$SRC/image_cache.hpp \
+    $$SRC/image_import_options.hpp \
+    $$SRC/image_importer.hpp \
     $$SRC/image_manager.hpp \
     $$SRC/png_export_dialog.hpp \
     $$SRC/layers.hpp \
@@ -53,6 +62,7 @@ HEADERS +=  \
     $$SRC/mediator.hpp \
     $$SRC/mind_map_data.hpp \
     $$SRC/mind_map_data_base.hpp \
+    $$SRC/mind_map_state.hpp \
     $$SRC/mouse_action.hpp \
     $$SRC/node.hpp \
     $$SRC/node_handle.hpp \
@@ -60,12 +70,16 @@ HEADERS +=  \
     $$SRC/recent_files_menu.hpp \
     $$SRC/selection_group.hpp \
     $$SRC/settings.hpp \
+    $$SRC/spatial_index.hpp \
     $$SRC/state_machine.hpp \
     $$SRC/svg_export_dialog.hpp \
     $$SRC/test_mode.hpp \
     $$SRC/text_edit.hpp \
+    $$SRC/undo_command.hpp \
+    $$SRC/undo_log.hpp \
     $$SRC/undo_stack.hpp \
     $$SRC/whats_new_dlg.hpp \
+    $$SRC/worker_pool.hpp \
     $$SRC/xml_reader.hpp \
     $$SRC/xml_writer.hpp \
     $$SRC/contrib/Argengine/src/argengine.hpp \
@@ -73,10 +87,15 @@ HEADERS +=  \
 
 SOURCES += \
     $$SRC/about_dlg.cpp \
+    $$SRC/alz_journal.cpp \
     $$SRC/alz_serializer.cpp \
+    $$SRC/alzb_serializer.cpp \
     $$SRC/application.cpp \
+    $$SRC/autosave_manager.cpp \
+    $$SRC/compressing_device.cpp \
     $$SRC/copy_paste.cpp \
     $$SRC/defaults.cpp \
+    $$SRC/decompressing_device.cpp \
     $$SRC/defaults_dlg.cpp \
     $$SRC/graph.cpp \
     $$SRC/graphics_factory.cpp \
@@ -85,11 +104,14 @@ SOURCES += \
     $$SRC/edge_context_menu.cpp \
     $$SRC/edge_dot.cpp \
     $$SRC/edge_text_edit.cpp \
+    $$SRC/edge_update_scheduler.cpp \
     $$SRC/editor_data.cpp \
     $$SRC/editor_scene.cpp \
     $$SRC/editor_view.cpp \
     $$SRC/hash_seed.cpp \
     $$SRC/image.cpp \
+    $$SRC/image_cache.cpp \
+    $$SRC/image_importer.cpp \
     $$SRC/image_manager.cpp \
     $$SRC/png_export_dialog.cpp \
     $$SRC/layout_optimization_dialog.cpp \
@@ -101,6 +123,7 @@ SOURCES += \
     $$SRC/mediator.cpp \
     $$SRC/mind_map_data.cpp \
     $$SRC/mind_map_data_base.cpp \
+    $$SRC/mind_map_state.cpp \
     $$SRC/mouse_action.cpp \
     $$SRC/node.cpp \
     $$SRC/node_handle.cpp \
@@ -108,10 +131,13 @@ SOURCES += \
     $$SRC/recent_files_menu.cpp \
     $$SRC/selection_group.cpp \
     $$SRC/settings.cpp \
+    $$SRC/spatial_index.cpp \
     $$SRC/state_machine.cpp \
     $$SRC/svg_export_dialog.cpp \
     $$SRC/test_mode.cpp \
     $$SRC/text_edit.cpp \
+    $$SRC/undo_command.cpp \
+    $$SRC/undo_log.cpp \
     $$SRC/undo_stack.cpp \
     $$SRC/whats_new_dlg.cpp \
     $$SRC/xml_reader.cpp \
@@ -0,0 +1,478 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "alz_journal.hpp"
+
+#include "alz_serializer.hpp"
+#include "constants.hpp"
+#include "file_exception.hpp"
+#include "graph.hpp"
+#include "mind_map_data.hpp"
+#include "node.hpp"
+#include "simple_logger.hpp"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace AlzJournal {
+namespace Keywords {
+
+static constexpr auto BASE = "base";
+
+static constexpr auto DELETE_EDGE = "delete-edge";
+
+static constexpr auto DELETE_NODE = "delete-node";
+
+static constexpr auto EDGE = "edge";
+
+static constexpr auto INDEX = "index";
+
+static constexpr auto INDEX0 = "index0";
+
+static constexpr auto INDEX1 = "index1";
+
+static constexpr auto JOURNAL = "journal";
+
+static constexpr auto MODIFIED = "modified";
+
+static constexpr auto NODE = "node";
+
+static constexpr auto SIZE = "size";
+
+} // namespace Keywords
+
+// Everything that is stored outside of <graph>, except for the view that would force a full save
+// after every scroll. Images are written to the base file only, so referring to an image that isn't
+// there yet needs a full save.
+static QByteArray designDigest(const MindMapState & state)
+{
+    QByteArray design;
+    QDataStream stream(&design, QIODevice::WriteOnly);
+    stream << state.design.backgroundColor << state.design.edgeColor << state.design.gridColor;
+    stream << state.design.edgeWidth << state.design.textSize << state.design.cornerRadius;
+    stream << state.design.aspectRatio << state.design.minEdgeLength;
+
+    const auto options = state.design.imageImportOptions;
+    stream << options.maxSize << options.format << options.quality;
+
+    std::set<size_t> imageIds;
+    for (auto && node : state.nodes) {
+        if (node.imageRef) {
+            const auto image = state.images.find(node.imageRef);
+            imageIds.insert(image != state.images.end() ? image->second.id() : node.imageRef);
+        }
+    }
+    for (auto && id : imageIds) {
+        stream << static_cast<quint64>(id);
+    }
+
+    return design;
+}
+
+static int key(const MindMapState::NodeState & node)
+{
+    return node.index;
+}
+
+static std::pair<int, int> key(const MindMapState::EdgeState & edge)
+{
+    return { edge.index0, edge.index1 };
+}
+
+// Walks the saved and the current elements, both sorted by key, and reports the ones that were added or changed and the ones that were removed
+template<typename T, typename Changed, typename Removed>
+static void diffSorted(const std::vector<T> & saved, const std::vector<T> & current, Changed changed, Removed removed)
+{
+    auto s = saved.begin();
+    auto c = current.begin();
+    while (s != saved.end() || c != current.end()) {
+        if (c == current.end() || (s != saved.end() && key(*s) < key(*c))) {
+            removed(*s++);
+        } else if (s == saved.end() || key(*c) < key(*s)) {
+            changed(*c++);
+        } else {
+            if (!(*s == *c)) {
+                changed(*c);
+            }
+            s++;
+            c++;
+        }
+    }
+}
+
+static QByteArray nodeElement(const MindMapState & state, const MindMapState::NodeState & node)
+{
+    QByteArray element;
+    QXmlStreamWriter writer(&element);
+    AlzSerializer::writeNode(state, node, writer);
+    return element + '\n';
+}
+
+static QByteArray edgeElement(const MindMapState::EdgeState & edge)
+{
+    QByteArray element;
+    QXmlStreamWriter writer(&element);
+    AlzSerializer::writeEdge(edge, writer);
+    return element + '\n';
+}
+
+// The base file is identified by its size and modification time
+static QByteArray baseStamp(QString filePath)
+{
+    const QFileInfo info(filePath);
+    if (!info.exists()) {
+        return {};
+    }
+
+    QByteArray stamp;
+    QXmlStreamWriter writer(&stamp);
+    writer.writeEmptyElement(Keywords::BASE);
+    writer.writeAttribute(Keywords::SIZE, QString::number(info.size()));
+    writer.writeAttribute(Keywords::MODIFIED, QString::number(info.lastModified().toMSecsSinceEpoch()));
+    writer.writeCharacters("\n");
+    return stamp;
+}
+
+Snapshot snapshot(const MindMapState & state, QString filePath)
+{
+    Snapshot snapshot;
+    snapshot.base = baseStamp(filePath);
+    snapshot.design = designDigest(state);
+    snapshot.nodes = state.nodes;
+    snapshot.edges = state.edges;
+    return snapshot;
+}
+
+Snapshot snapshot(const MindMapData & mindMapData, QString filePath)
+{
+    return snapshot(MindMapState::captureForSaving(mindMapData), filePath);
+}
+
+bool diff(const MindMapState & state, QString filePath, const Snapshot & saved, Snapshot & current, QByteArray & records)
+{
+    current = {};
+    current.base = saved.base;
+    current.design = designDigest(state);
+    current.nodes = state.nodes;
+    current.edges = state.edges;
+
+    if (current.design != saved.design || saved.base.isEmpty() || saved.base != baseStamp(filePath)) {
+        return false;
+    }
+
+    // Deletions go first so that a node re-added with the same index is not deleted afterwards
+    QByteArray deleteRecords;
+    QXmlStreamWriter writer(&deleteRecords);
+
+    QByteArray edgeRecords;
+    diffSorted(
+      saved.edges, current.edges, [&edgeRecords](const MindMapState::EdgeState & edge) {
+          edgeRecords += edgeElement(edge);
+      },
+      [&writer](const MindMapState::EdgeState & edge) {
+          writer.writeEmptyElement(Keywords::DELETE_EDGE);
+          writer.writeAttribute(Keywords::INDEX0, QString::number(edge.index0));
+          writer.writeAttribute(Keywords::INDEX1, QString::number(edge.index1));
+          writer.writeCharacters("\n");
+      });
+
+    QByteArray nodeRecords;
+    diffSorted(
+      saved.nodes, current.nodes, [&nodeRecords, &state](const MindMapState::NodeState & node) {
+          nodeRecords += nodeElement(state, node);
+      },
+      [&writer](const MindMapState::NodeState & node) {
+          writer.writeEmptyElement(Keywords::DELETE_NODE);
+          writer.writeAttribute(Keywords::INDEX, QString::number(node.index));
+          writer.writeCharacters("\n");
+      });
+
+    records = deleteRecords + nodeRecords + edgeRecords;
+    return true;
+}
+
+bool diff(const MindMapData & mindMapData, QString filePath, const Snapshot & saved, Snapshot & current, QByteArray & records)
+{
+    return diff(MindMapState::captureForSaving(mindMapData), filePath, saved, current, records);
+}
+
+QString journalPath(QString filePath)
+{
+    return filePath + Constants::Application::JOURNAL_FILE_EXTENSION;
+}
+
+bool append(QString filePath, const QByteArray & records)
+{
+    const auto stamp = baseStamp(filePath);
+    if (stamp.isEmpty()) {
+        return false;
+    }
+
+    QFile file(journalPath(filePath));
+    if (!file.open(QIODevice::ReadWrite)) {
+        juzzlin::L().error() << "Cannot open journal '" << file.fileName().toStdString() << "': " << file.errorString().toStdString();
+        return false;
+    }
+
+    // Start over if the journal belongs to an older base file, as it would be ignored on load.
+    // Write everything at once so that a crash can only tear the last record.
+    const bool isNew = file.read(stamp.size()) != stamp;
+    const auto data = isNew ? stamp + records : records;
+    if ((isNew && !file.resize(0)) || !file.seek(file.size()) || file.write(data) != data.size() || !file.flush()) {
+        juzzlin::L().error() << "Cannot write journal '" << file.fileName().toStdString() << "': " << file.errorString().toStdString();
+        return false;
+    }
+
+    return true;
+}
+
+// Applies records to the nodes and edges by their keys, so that a record doesn't need to search the graph.
+// The graph is rebuilt once at the end if nodes or edges were added or deleted.
+class GraphReplay
+{
+public:
+    explicit GraphReplay(Graph & graph)
+      : m_graph(graph)
+      , m_nodeOrder(graph.getNodes())
+      , m_edgeOrder(graph.getEdges())
+    {
+        for (auto && node : m_nodeOrder) {
+            m_nodes[node->index()] = node;
+        }
+        for (auto && edge : m_edgeOrder) {
+            m_edges[key(*edge)] = edge;
+        }
+    }
+
+    Node & node(int index) const
+    {
+        const auto iter = m_nodes.find(index);
+        if (iter == m_nodes.end()) {
+            throw std::runtime_error("Invalid node index: " + std::to_string(index));
+        }
+        return *iter->second;
+    }
+
+    void upsertNode(std::unique_ptr<Node> node)
+    {
+        const auto iter = m_nodes.find(node->index());
+        if (iter != m_nodes.end()) {
+            iter->second->setLocation(node->location());
+            iter->second->setSize(node->size());
+            iter->second->setText(node->text());
+            iter->second->setColor(node->color());
+            iter->second->setTextColor(node->textColor());
+            iter->second->setImageRef(node->imageRef());
+        } else {
+            NodePtr added = std::move(node);
+            m_nodes[added->index()] = added;
+            m_nodeOrder.push_back(added);
+            m_changed = true;
+        }
+    }
+
+    void upsertEdge(std::unique_ptr<Edge> edge)
+    {
+        const auto iter = m_edges.find(key(*edge));
+        if (iter != m_edges.end() && isLive(*iter->second)) {
+            iter->second->setArrowMode(edge->arrowMode());
+            iter->second->setReversed(edge->reversed());
+            iter->second->setText(edge->text());
+        } else {
+            EdgePtr added = std::move(edge);
+            m_edges[key(*added)] = added;
+            m_edgeOrder.push_back(added);
+            m_changed = true;
+        }
+    }
+
+    //! Edges of the node are dropped when the graph is rebuilt.
+    void deleteNode(int index)
+    {
+        m_changed |= m_nodes.erase(index) > 0;
+    }
+
+    void deleteEdge(int index0, int index1)
+    {
+        m_changed |= m_edges.erase({ index0, index1 }) > 0;
+    }
+
+    void finish()
+    {
+        if (!m_changed) {
+            return;
+        }
+
+        Graph::NodeVector nodes;
+        for (auto && node : m_nodeOrder) {
+            if (isLive(*node)) {
+                nodes.push_back(node);
+            }
+        }
+
+        Graph::EdgeVector edges;
+        for (auto && edge : m_edgeOrder) {
+            const auto iter = m_edges.find(key(*edge));
+            if (iter != m_edges.end() && iter->second == edge && isLive(*edge)) {
+                edges.push_back(edge);
+            }
+        }
+
+        m_graph.replace(std::move(nodes), std::move(edges));
+    }
+
+private:
+    static std::pair<int, int> key(const Edge & edge)
+    {
+        return { edge.sourceNode().index(), edge.targetNode().index() };
+    }
+
+    //! A node deleted and then re-added with the same index is a different object.
+    bool isLive(const Node & node) const
+    {
+        const auto iter = m_nodes.find(node.index());
+        return iter != m_nodes.end() && iter->second.get() == &node;
+    }
+
+    bool isLive(const Edge & edge) const
+    {
+        return isLive(edge.sourceNode()) && isLive(edge.targetNode());
+    }
+
+    Graph & m_graph;
+
+    Graph::NodeVector m_nodeOrder;
+
+    Graph::EdgeVector m_edgeOrder;
+
+    std::map<int, NodePtr> m_nodes;
+
+    std::map<std::pair<int, int>, EdgePtr> m_edges;
+
+    bool m_changed = false;
+};
+
+// Applies records until the end or the first malformed one. A record is applied only after it has been read completely.
+// \return Character offset of the end of the last complete record.
+static qint64 applyRecords(QXmlStreamReader & reader, GraphReplay & graphReplay)
+{
+    const auto getNode = [&graphReplay](int index) -> Node & {
+        return graphReplay.node(index);
+    };
+
+    auto recordsEnd = reader.characterOffset();
+    while (reader.readNextStartElement()) {
+        const auto name = reader.name().toString();
+        if (name == Keywords::NODE) {
+            auto node = AlzSerializer::readNode(reader);
+            if (!reader.hasError()) {
+                graphReplay.upsertNode(std::move(node));
+            }
+        } else if (name == Keywords::EDGE) {
+            auto edge = AlzSerializer::readEdge(reader, getNode);
+            if (!reader.hasError()) {
+                graphReplay.upsertEdge(std::move(edge));
+            }
+        } else if (name == Keywords::DELETE_NODE) {
+            const auto index = reader.attributes().value(Keywords::INDEX).toInt();
+            reader.skipCurrentElement();
+            if (!reader.hasError()) {
+                graphReplay.deleteNode(index);
+            }
+        } else if (name == Keywords::DELETE_EDGE) {
+            const auto index0 = reader.attributes().value(Keywords::INDEX0).toInt();
+            const auto index1 = reader.attributes().value(Keywords::INDEX1).toInt();
+            reader.skipCurrentElement();
+            if (!reader.hasError()) {
+                graphReplay.deleteEdge(index0, index1);
+            }
+        } else {
+            juzzlin::L().warning() << "Unknown journal record '" << name.toStdString() << "'";
+            reader.skipCurrentElement();
+        }
+        if (!reader.hasError()) {
+            recordsEnd = reader.characterOffset();
+        }
+    }
+    return recordsEnd;
+}
+
+void replay(QString filePath, MindMapData & mindMapData)
+{
+    QFile file(journalPath(filePath));
+    if (!file.exists()) {
+        return;
+    }
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw FileException(QObject::tr("Cannot open file: '") + file.fileName() + "'");
+    }
+
+    // The journal is a sequence of elements without a root, so wrap it into one
+    const auto journal = file.readAll();
+    const auto stamp = baseStamp(filePath);
+    if (stamp.isEmpty() || !journal.startsWith(stamp)) {
+        juzzlin::L().warning() << "Ignoring stale journal '" << file.fileName().toStdString() << "'";
+        return;
+    }
+
+    const auto rootStartTag = QByteArray("<") + Keywords::JOURNAL + ">";
+    const auto records = journal.mid(stamp.size());
+    QXmlStreamReader reader(rootStartTag + records + "</" + Keywords::JOURNAL + ">");
+    reader.readNextStartElement();
+
+    qint64 recordsEnd = 0;
+    try {
+        GraphReplay graphReplay(mindMapData.graph());
+        recordsEnd = applyRecords(reader, graphReplay);
+        graphReplay.finish();
+    } catch (const std::runtime_error & e) {
+        juzzlin::L().error() << e.what();
+        throw FileException(QObject::tr("Corrupted file: '") + file.fileName() + "'");
+    }
+
+    // Records appended later would end up after the torn one and be ignored as well, so drop it right away
+    if (reader.hasError()) {
+        juzzlin::L().warning() << "Dropping truncated journal tail at line " << reader.lineNumber() << ": " << reader.errorString().toStdString();
+        const auto goodRecords = QString::fromUtf8(records).left(static_cast<int>(recordsEnd) - rootStartTag.size()).toUtf8();
+        file.close();
+        if (!QFile::resize(file.fileName(), stamp.size() + goodRecords.size())) {
+            juzzlin::L().error() << "Cannot truncate journal '" << file.fileName().toStdString() << "'";
+        }
+    }
+}
+
+qint64 size(QString filePath)
+{
+    return QFileInfo(journalPath(filePath)).size();
+}
+
+void remove(QString filePath)
+{
+    QFile::remove(journalPath(filePath));
+}
+
+} // namespace AlzJournal
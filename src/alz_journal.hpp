@@ -0,0 +1,79 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ALZ_JOURNAL_HPP
+#define ALZ_JOURNAL_HPP
+
+#include "mind_map_state.hpp"
+
+#include <QByteArray>
+#include <QString>
+
+#include <vector>
+
+class MindMapData;
+
+//! Append-only change journal for incremental saves. Edits made after the last full save are
+//! appended as node and edge records to a sidecar file next to the mind map, and replayed on load.
+//! The journal is stamped with the size and modification time of the base file so that a journal
+//! left behind by an older base file is never applied.
+//! The view is not journaled: it only changes with a full save, so a replayed mind map opens at the
+//! view of the base file.
+namespace AlzJournal {
+
+//! The mind map as it is on disk (base file plus journal). The graph is kept as plain data, so
+//! it's compared with the current state like in undo and only the changed elements get serialized.
+struct Snapshot
+{
+    QByteArray base;
+
+    QByteArray design;
+
+    //! Sorted by index.
+    std::vector<MindMapState::NodeState> nodes;
+
+    //! Sorted by (index0, index1).
+    std::vector<MindMapState::EdgeState> edges;
+};
+
+//! Takes the snapshot of the mind map just saved to or loaded from filePath.
+Snapshot snapshot(const MindMapState & state, QString filePath);
+
+Snapshot snapshot(const MindMapData & mindMapData, QString filePath);
+
+//! Builds the records that turn the saved state into the current one. The new state is stored to current.
+//! \return false if the change cannot be expressed as graph records (e.g. design or images changed)
+//! or the base file has changed on disk, and a full save is needed.
+bool diff(const MindMapState & state, QString filePath, const Snapshot & saved, Snapshot & current, QByteArray & records);
+
+bool diff(const MindMapData & mindMapData, QString filePath, const Snapshot & saved, Snapshot & current, QByteArray & records);
+
+QString journalPath(QString filePath);
+
+//! Appends the records, starting a new journal stamped with the base file if needed.
+bool append(QString filePath, const QByteArray & records);
+
+//! Applies the journal of the given base file, if any. A truncated tail (e.g. after a crash) is ignored
+//! and cut off the journal so that new records can be appended.
+//! Throws FileException if a record refers to nodes that don't exist.
+void replay(QString filePath, MindMapData & mindMapData);
+
+qint64 size(QString filePath);
+
+void remove(QString filePath);
+
+} // namespace AlzJournal
+
+#endif // ALZ_JOURNAL_HPP
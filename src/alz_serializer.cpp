@@ -21,15 +21,23 @@
 #include "node.hpp"
 #include "simple_logger.hpp"
 #include "test_mode.hpp"
+#include "worker_pool.hpp"
 
+#include <algorithm>
 #include <cassert>
-#include <functional>
+#include <cstring>
+#include <future>
 #include <map>
+#include <stdexcept>
+#include <set>
+#include <string>
+#include <vector>
 
 #include <QDebug>
-#include <QDomElement>
 #include <QFile>
-#include <QTemporaryDir>
+#include <QIODevice>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 namespace AlzSerializer {
 namespace DataKeywords {
@@ -118,6 +126,18 @@ static constexpr auto PATH = "path";
 
 } // namespace Image
 
+namespace ImageImport {
+
+static constexpr auto FORMAT = "format";
+
+static constexpr auto IMAGE_IMPORT = "image-import";
+
+static constexpr auto MAX_SIZE = "max-size";
+
+static constexpr auto QUALITY = "quality";
+
+} // namespace ImageImport
+
 namespace LayoutOptimizer {
 
 static constexpr auto ASPECT_RATIO = "aspect-ratio";
@@ -128,354 +148,838 @@ static constexpr auto MIN_EDGE_LENGTH = "min-edge-length";
 
 } // namespace LayoutOptimizer
 
+namespace View {
+
+static constexpr auto VIEW = "view";
+
+static constexpr auto X = "x";
+
+static constexpr auto Y = "y";
+
+static constexpr auto W = "w";
+
+static constexpr auto H = "h";
+
+} // namespace View
+
 } // namespace Design
 
 } // namespace DataKeywords
 
 static const double SCALE = 1000; // https://bugreports.qt.io/browse/QTBUG-67129
 
-static void writeColor(QDomElement & parent, QDomDocument & doc, QColor color, QString elementName)
+static const qint64 BASE64_CHUNK_SIZE = 3 * 64 * 1024;
+
+static void writeColor(QXmlStreamWriter & writer, QColor color, QString elementName)
 {
-    auto colorElement = doc.createElement(elementName);
-    colorElement.setAttribute(DataKeywords::Design::Color::R, color.red());
-    colorElement.setAttribute(DataKeywords::Design::Color::G, color.green());
-    colorElement.setAttribute(DataKeywords::Design::Color::B, color.blue());
-    parent.appendChild(colorElement);
+    writer.writeStartElement(elementName);
+    writer.writeAttribute(DataKeywords::Design::Color::R, QString::number(color.red()));
+    writer.writeAttribute(DataKeywords::Design::Color::G, QString::number(color.green()));
+    writer.writeAttribute(DataKeywords::Design::Color::B, QString::number(color.blue()));
+    writer.writeEndElement();
 }
 
-static void writeImageRef(QDomElement & parent, QDomDocument & doc, size_t imageRef, QString elementName)
+static void writeImageRef(QXmlStreamWriter & writer, size_t imageRef, QString elementName)
 {
-    auto colorElement = doc.createElement(elementName);
-    colorElement.setAttribute(DataKeywords::Design::Graph::Node::Image::REF, static_cast<int>(imageRef));
-    parent.appendChild(colorElement);
+    writer.writeStartElement(elementName);
+    writer.writeAttribute(DataKeywords::Design::Graph::Node::Image::REF, QString::number(static_cast<int>(imageRef)));
+    writer.writeEndElement();
 }
 
-static void writeNodes(MindMapData & mindMapData, QDomElement & root, QDomDocument & doc)
+// Refer to the canonical id so that shared images are written only once
+static size_t canonicalImageRef(const MindMapState & state, size_t imageRef)
 {
-    for (auto && node : mindMapData.graph().getNodes()) {
-        auto nodeElement = doc.createElement(DataKeywords::Design::Graph::NODE);
-        nodeElement.setAttribute(DataKeywords::Design::Graph::Node::INDEX, node->index());
-        nodeElement.setAttribute(DataKeywords::Design::Graph::Node::X, static_cast<int>(node->location().x() * SCALE));
-        nodeElement.setAttribute(DataKeywords::Design::Graph::Node::Y, static_cast<int>(node->location().y() * SCALE));
-        nodeElement.setAttribute(DataKeywords::Design::Graph::Node::W, static_cast<int>(node->size().width() * SCALE));
-        nodeElement.setAttribute(DataKeywords::Design::Graph::Node::H, static_cast<int>(node->size().height() * SCALE));
-        root.appendChild(nodeElement);
+    const auto image = state.images.find(imageRef);
+    return image != state.images.end() ? image->second.id() : imageRef;
+}
 
-        // Create a child node for the text content
-        auto textElement = doc.createElement(DataKeywords::Design::Graph::Node::TEXT);
-        textElement.appendChild(doc.createTextNode(node->text()));
-        nodeElement.appendChild(textElement);
+void writeNode(const MindMapState & state, const MindMapState::NodeState & node, QXmlStreamWriter & writer)
+{
+    writer.writeStartElement(DataKeywords::Design::Graph::NODE);
+    writer.writeAttribute(DataKeywords::Design::Graph::Node::INDEX, QString::number(node.index));
+    writer.writeAttribute(DataKeywords::Design::Graph::Node::X, QString::number(static_cast<int>(node.location.x() * SCALE)));
+    writer.writeAttribute(DataKeywords::Design::Graph::Node::Y, QString::number(static_cast<int>(node.location.y() * SCALE)));
+    writer.writeAttribute(DataKeywords::Design::Graph::Node::W, QString::number(static_cast<int>(node.size.width() * SCALE)));
+    writer.writeAttribute(DataKeywords::Design::Graph::Node::H, QString::number(static_cast<int>(node.size.height() * SCALE)));
 
-        // Create a child node for color
-        writeColor(nodeElement, doc, node->color(), DataKeywords::Design::Graph::Node::COLOR);
+    // Create a child node for the text content
+    writer.writeTextElement(DataKeywords::Design::Graph::Node::TEXT, node.text);
 
-        // Create a child node for text color
-        writeColor(nodeElement, doc, node->textColor(), DataKeywords::Design::Graph::Node::TEXT_COLOR);
+    // Create a child node for color
+    writeColor(writer, node.color, DataKeywords::Design::Graph::Node::COLOR);
 
-        // Create a child node for image ref
-        if (node->imageRef()) {
-            writeImageRef(nodeElement, doc, node->imageRef(), DataKeywords::Design::Graph::Node::IMAGE);
-        }
+    // Create a child node for text color
+    writeColor(writer, node.textColor, DataKeywords::Design::Graph::Node::TEXT_COLOR);
+
+    // Create a child node for image ref
+    if (node.imageRef) {
+        writeImageRef(writer, canonicalImageRef(state, node.imageRef), DataKeywords::Design::Graph::Node::IMAGE);
+    }
+
+    writer.writeEndElement();
+}
+
+static void writeNodes(const MindMapState & state, QXmlStreamWriter & writer)
+{
+    for (auto && node : state.nodes) {
+        writeNode(state, node, writer);
     }
 }
 
-static void writeEdges(MindMapData & mindMapData, QDomElement & root, QDomDocument & doc)
+void writeEdge(const MindMapState::EdgeState & edge, QXmlStreamWriter & writer)
 {
-    for (auto && node : mindMapData.graph().getNodes()) {
-        for (auto && edge : mindMapData.graph().getEdgesFromNode(node)) {
-            auto edgeElement = doc.createElement(DataKeywords::Design::Graph::EDGE);
-            edgeElement.setAttribute(DataKeywords::Design::Graph::Edge::INDEX0, edge->sourceNode().index());
-            edgeElement.setAttribute(DataKeywords::Design::Graph::Edge::INDEX1, edge->targetNode().index());
-            edgeElement.setAttribute(DataKeywords::Design::Graph::Edge::ARROW_MODE, static_cast<int>(edge->arrowMode()));
-            edgeElement.setAttribute(DataKeywords::Design::Graph::Edge::REVERSED, edge->reversed());
-            root.appendChild(edgeElement);
+    writer.writeStartElement(DataKeywords::Design::Graph::EDGE);
+    writer.writeAttribute(DataKeywords::Design::Graph::Edge::INDEX0, QString::number(edge.index0));
+    writer.writeAttribute(DataKeywords::Design::Graph::Edge::INDEX1, QString::number(edge.index1));
+    writer.writeAttribute(DataKeywords::Design::Graph::Edge::ARROW_MODE, QString::number(static_cast<int>(edge.arrowMode)));
+    writer.writeAttribute(DataKeywords::Design::Graph::Edge::REVERSED, QString::number(edge.reversed));
 
-            // Create a child node for the text content
-            auto textElement = doc.createElement(DataKeywords::Design::Graph::Node::TEXT);
-            edgeElement.appendChild(textElement);
-            const auto textNode = doc.createTextNode(edge->text());
-            textElement.appendChild(textNode);
-        }
+    // Create a child node for the text content
+    writer.writeTextElement(DataKeywords::Design::Graph::Node::TEXT, edge.text);
+
+    writer.writeEndElement();
+}
+
+static void writeEdges(const MindMapState & state, QXmlStreamWriter & writer)
+{
+    for (auto && edge : state.edges) {
+        writeEdge(edge, writer);
     }
 }
 
-static QString getBase64Data(std::string path)
+// Writes the image from memory. Images that only have a path (e.g. created by older versions
+// of the code) are streamed from the file as base64 so that the content is not held in memory as a whole.
+static void writeBase64Data(QXmlStreamWriter & writer, const Image & image)
 {
-    if (!TestMode::enabled()) {
+    const auto base64 = image.base64Data();
+    if (!base64.isEmpty()) {
+        // The cached form is written in chunks as well so that it's never converted to a QString as a whole
+        const auto chunkSize = static_cast<int>(BASE64_CHUNK_SIZE / 3 * 4);
+        for (int pos = 0; pos < base64.size(); pos += chunkSize) {
+            writer.writeCharacters(QString::fromLatin1(base64.constData() + pos, std::min(chunkSize, base64.size() - pos)));
+        }
+    } else if (!image.data().isEmpty()) {
+        // Chunk size must be a multiple of 3 so that no padding is emitted between the chunks
+        const auto data = image.data();
+        for (int pos = 0; pos < data.size(); pos += static_cast<int>(BASE64_CHUNK_SIZE)) {
+            const auto chunk = QByteArray::fromRawData(data.constData() + pos, std::min(static_cast<int>(BASE64_CHUNK_SIZE), data.size() - pos));
+            writer.writeCharacters(QString::fromLatin1(chunk.toBase64(QByteArray::Base64Encoding)));
+        }
+    } else if (!TestMode::enabled()) {
+        const auto path = image.path();
         QFile in(path.c_str());
         if (!in.open(QIODevice::ReadOnly)) {
             throw std::runtime_error("Cannot open file: '" + path + "'");
         }
-        return in.readAll().toBase64(QByteArray::Base64Encoding);
+        while (!in.atEnd()) {
+            const auto chunk = in.read(BASE64_CHUNK_SIZE);
+            if (chunk.isEmpty()) {
+                throw std::runtime_error("Cannot read file: '" + path + "'");
+            }
+            writer.writeCharacters(QString::fromLatin1(chunk.toBase64(QByteArray::Base64Encoding)));
+        }
     } else {
-        TestMode::logDisabledCode("getBase64Data");
-        return {};
+        TestMode::logDisabledCode("writeBase64Data");
     }
 }
 
-static QImage base64ToQImage(const std::string & base64, size_t imageId, std::string imagePath)
+// Base64 decoding and hashing happen on the worker pool so that they overlap with the rest of the parse.
+// The image itself stays encoded until ImageCache needs it.
+static std::future<Image> base64ToImage(QByteArray base64, size_t imageId, std::string imagePath)
 {
-    if (!TestMode::enabled()) {
-        QTemporaryDir dir;
-        if (dir.isValid()) {
-            QFileInfo info(imagePath.c_str());
-            const auto extractedFilePath = (dir.path() + QDir::separator() + info.fileName()).toStdString();
-            juzzlin::L().info() << "Extracting embedded image id=" << imageId << " to '" << extractedFilePath << "'";
-            QByteArray bytes = QByteArray::fromBase64(base64.c_str(), QByteArray::Base64Encoding);
-            QFile out(extractedFilePath.c_str());
-            if (!out.open(QIODevice::WriteOnly)) {
-                throw std::runtime_error("Cannot open file: '" + extractedFilePath + "' for write!");
-            }
-            auto bytesWritten = out.write(bytes);
-            juzzlin::L().info() << "Bytes written: " << bytesWritten << ", " << (bytesWritten == bytes.length() ? "OK" : "SIZE MISMATCH");
-            return QImage { extractedFilePath.c_str() };
-        } else {
-            throw std::runtime_error("Temp dir not valid: '" + dir.path().toStdString() + "'");
+    return WorkerPool::run([base64, imageId, imagePath] {
+        Image image(QByteArray::fromBase64(base64, QByteArray::Base64Encoding), imagePath);
+        juzzlin::L().debug() << "Extracted embedded image id=" << imageId << ", " << image.data().size() << " bytes";
+        image.setId(imageId);
+        image.setBase64Data(base64); // Saving back unchanged needs no re-encoding
+        return image;
+    });
+}
+
+static void writeImages(const MindMapState & state, QXmlStreamWriter & writer)
+{
+    std::set<size_t> writtenIds;
+    for (auto && node : state.nodes) {
+        const auto image = state.images.find(node.imageRef);
+        if (image != state.images.end() && writtenIds.insert(image->second.id()).second) {
+            writer.writeStartElement(DataKeywords::Design::IMAGE);
+            writer.writeAttribute(DataKeywords::Design::Image::ID, QString::number(static_cast<int>(image->second.id())));
+            writer.writeAttribute(DataKeywords::Design::Image::PATH, image->second.path().c_str());
+
+            // Create a child node for the image content
+            writeBase64Data(writer, image->second);
+
+            writer.writeEndElement();
         }
-    } else {
-        TestMode::logDisabledCode("base64ToQImage");
     }
-    return {};
 }
 
-static void writeImages(MindMapData & mindMapData, QDomElement & root, QDomDocument & doc)
+static void writeLayoutOptimizer(const MindMapState & state, QXmlStreamWriter & writer)
+{
+    writer.writeStartElement(DataKeywords::Design::LayoutOptimizer::LAYOUT_OPTIMIZER);
+    writer.writeAttribute(DataKeywords::Design::LayoutOptimizer::ASPECT_RATIO, QString::number(state.design.aspectRatio * SCALE));
+    writer.writeAttribute(DataKeywords::Design::LayoutOptimizer::MIN_EDGE_LENGTH, QString::number(state.design.minEdgeLength * SCALE));
+    writer.writeEndElement();
+}
+
+static void writeImageImport(const MindMapState & state, QXmlStreamWriter & writer)
 {
-    for (auto && node : mindMapData.graph().getNodes()) {
-        if (node->imageRef()) {
-            Image image;
-            bool exists;
-            std::tie(image, exists) = mindMapData.imageManager().getImage(node->imageRef());
-            if (exists) {
-                auto imageElement = doc.createElement(DataKeywords::Design::IMAGE);
-                imageElement.setAttribute(DataKeywords::Design::Image::ID, static_cast<int>(image.id()));
-                imageElement.setAttribute(DataKeywords::Design::Image::PATH, image.path().c_str());
-                root.appendChild(imageElement);
+    const auto options = state.design.imageImportOptions;
+    writer.writeStartElement(DataKeywords::Design::ImageImport::IMAGE_IMPORT);
+    writer.writeAttribute(DataKeywords::Design::ImageImport::MAX_SIZE, QString::number(options.maxSize));
+    writer.writeAttribute(DataKeywords::Design::ImageImport::FORMAT, options.format);
+    writer.writeAttribute(DataKeywords::Design::ImageImport::QUALITY, QString::number(options.quality));
+    writer.writeEndElement();
+}
 
-                // Create a child node for the image content
-                imageElement.appendChild(doc.createTextNode(getBase64Data(image.path())));
-            }
-        }
+static void writeView(const MindMapState & state, QXmlStreamWriter & writer)
+{
+    const auto viewRect = state.viewRect;
+    if (!viewRect.isValid()) {
+        return;
     }
+
+    writer.writeStartElement(DataKeywords::Design::View::VIEW);
+    writer.writeAttribute(DataKeywords::Design::View::X, QString::number(static_cast<int>(viewRect.x() * SCALE)));
+    writer.writeAttribute(DataKeywords::Design::View::Y, QString::number(static_cast<int>(viewRect.y() * SCALE)));
+    writer.writeAttribute(DataKeywords::Design::View::W, QString::number(static_cast<int>(viewRect.width() * SCALE)));
+    writer.writeAttribute(DataKeywords::Design::View::H, QString::number(static_cast<int>(viewRect.height() * SCALE)));
+    writer.writeEndElement();
 }
 
-static void writeLayoutOptimizer(MindMapData & mindMapData, QDomElement & root, QDomDocument & doc)
+static QString readAttribute(const QXmlStreamAttributes & attributes, const char * name, QString defaultValue = {})
 {
-    auto layoutOptimizerElement = doc.createElement(DataKeywords::Design::LayoutOptimizer::LAYOUT_OPTIMIZER);
-    layoutOptimizerElement.setAttribute(DataKeywords::Design::LayoutOptimizer::ASPECT_RATIO, mindMapData.aspectRatio() * SCALE);
-    layoutOptimizerElement.setAttribute(DataKeywords::Design::LayoutOptimizer::MIN_EDGE_LENGTH, mindMapData.minEdgeLength() * SCALE);
-    root.appendChild(layoutOptimizerElement);
+    const QLatin1String key(name);
+    return attributes.hasAttribute(key) ? attributes.value(key).toString() : defaultValue;
 }
 
-static QColor readColorElement(const QDomElement & element)
+static QColor readColorElement(QXmlStreamReader & reader)
 {
-    return {
-        element.attribute(DataKeywords::Design::Color::R, "255").toInt(),
-        element.attribute(DataKeywords::Design::Color::G, "255").toInt(),
-        element.attribute(DataKeywords::Design::Color::B, "255").toInt()
+    const auto attributes = reader.attributes();
+    const QColor color {
+        readAttribute(attributes, DataKeywords::Design::Color::R, "255").toInt(),
+        readAttribute(attributes, DataKeywords::Design::Color::G, "255").toInt(),
+        readAttribute(attributes, DataKeywords::Design::Color::B, "255").toInt()
     };
+    reader.skipCurrentElement();
+    return color;
 }
 
-static size_t readImageElement(const QDomElement & element)
+static size_t readImageElement(QXmlStreamReader & reader)
 {
-    return static_cast<size_t>(element.attribute(DataKeywords::Design::Graph::Node::Image::REF, "0").toInt());
+    const auto ref = static_cast<size_t>(readAttribute(reader.attributes(), DataKeywords::Design::Graph::Node::Image::REF, "0").toInt());
+    reader.skipCurrentElement();
+    return ref;
 }
 
-static QString readFirstTextNodeContent(const QDomElement & element)
+static QString readFirstTextNodeContent(QXmlStreamReader & reader)
 {
-    for (int i = 0; i < element.childNodes().count(); i++) {
-        const auto child = element.childNodes().at(i);
-        if (child.isText()) {
-            // See: https://github.com/juzzlin/Heimer/issues/73
-            return child.toText().nodeValue().replace(13, "");
-        }
+    // See: https://github.com/juzzlin/Heimer/issues/73
+    return reader.readElementText(QXmlStreamReader::SkipChildElements).replace(13, "");
+}
+
+static void elementWarning(const QXmlStreamReader & reader)
+{
+    juzzlin::L().warning() << "Unknown element '" << reader.name().toString().toStdString() << "'";
+}
+
+using TagId = quint64;
+
+// 64-bit FNV-1a so that element names can be dispatched with a switch over compile-time constants
+static constexpr TagId tagId(const char * name)
+{
+    TagId hash = 14695981039346656037ull;
+    while (*name) {
+        hash = (hash ^ static_cast<unsigned char>(*name++)) * 1099511628211ull;
     }
-    return {};
+    return hash;
 }
 
-static void elementWarning(const QDomElement & element)
+// Hashes the UTF-16 code units of the current element name, which equals tagId() for the ASCII keywords
+// without allocating a QString
+static TagId tagId(const QXmlStreamReader & reader)
 {
-    juzzlin::L().warning() << "Unknown element '" << element.nodeName().toStdString() << "'";
+    const auto name = reader.name();
+    TagId hash = 14695981039346656037ull;
+    for (int i = 0; i < name.size(); i++) {
+        hash = (hash ^ name.at(i).unicode()) * 1099511628211ull;
+    }
+    return hash;
 }
 
-// Generic helper that loops through element's children
-static void readChildren(const QDomElement & root, std::map<QString, std::function<void(const QDomElement &)>> handlerMap)
+// Generic helper that loops through element's children. The handler is called with the tag id of each child,
+// must consume the element if it recognizes the tag, and returns false otherwise.
+template<typename Handler>
+static void readChildren(QXmlStreamReader & reader, Handler && handler)
 {
-    auto domNode = root.firstChild();
-    while (!domNode.isNull()) {
-        const auto element = domNode.toElement();
-        if (!element.isNull()) {
-            if (handlerMap.count(element.nodeName())) {
-                handlerMap[element.nodeName()](element);
-            } else {
-                elementWarning(element);
-            }
+    while (reader.readNextStartElement()) {
+        if (!handler(reader, tagId(reader))) {
+            elementWarning(reader);
+            reader.skipCurrentElement();
         }
-
-        domNode = domNode.nextSibling();
     }
 }
 
 // The purpose of this #ifdef is to build GUILESS unit tests so that QTEST_GUILESS_MAIN can be used
-static std::unique_ptr<Node> readNode(const QDomElement & element)
+std::unique_ptr<Node> readNode(QXmlStreamReader & reader)
 {
     // Init a new node. QGraphicsScene will take the ownership eventually.
     auto node = std::make_unique<Node>();
 
-    node->setIndex(element.attribute(DataKeywords::Design::Graph::Node::INDEX, "-1").toInt());
+    const auto attributes = reader.attributes();
+    node->setIndex(readAttribute(attributes, DataKeywords::Design::Graph::Node::INDEX, "-1").toInt());
     node->setLocation(QPointF(
-      element.attribute(DataKeywords::Design::Graph::Node::X, "0").toInt() / SCALE,
-      element.attribute(DataKeywords::Design::Graph::Node::Y, "0").toInt() / SCALE));
-
-    if (element.hasAttribute(DataKeywords::Design::Graph::Node::W) && element.hasAttribute(DataKeywords::Design::Graph::Node::H)) {
-        node->setSize(QSizeF(
-          element.attribute(DataKeywords::Design::Graph::Node::W).toInt() / SCALE,
-          element.attribute(DataKeywords::Design::Graph::Node::H).toInt() / SCALE));
+      readAttribute(attributes, DataKeywords::Design::Graph::Node::X, "0").toInt() / SCALE,
+      readAttribute(attributes, DataKeywords::Design::Graph::Node::Y, "0").toInt() / SCALE));
+
+    // The saved size is used as is, so that the text doesn't need to be laid out
+    QSizeF size;
+    if (attributes.hasAttribute(QLatin1String(DataKeywords::Design::Graph::Node::W)) && attributes.hasAttribute(QLatin1String(DataKeywords::Design::Graph::Node::H))) {
+        size = QSizeF(
+          readAttribute(attributes, DataKeywords::Design::Graph::Node::W).toInt() / SCALE,
+          readAttribute(attributes, DataKeywords::Design::Graph::Node::H).toInt() / SCALE);
     }
 
-    readChildren(element, { { QString(DataKeywords::Design::Graph::Node::TEXT), [&node](const QDomElement & e) {
-                                 node->setText(readFirstTextNodeContent(e));
-                             } },
-                            { QString(DataKeywords::Design::Graph::Node::COLOR), [&node](const QDomElement & e) {
-                                 node->setColor(readColorElement(e));
-                             } },
-                            { QString(DataKeywords::Design::Graph::Node::TEXT_COLOR), [&node](const QDomElement & e) {
-                                 node->setTextColor(readColorElement(e));
-                             } },
-                            { QString(DataKeywords::Design::Graph::Node::IMAGE), [&node](const QDomElement & e) {
-                                 node->setImageRef(readImageElement(e));
-                             } } });
+    QString text;
+    readChildren(reader, [&node, &text](QXmlStreamReader & r, TagId tag) {
+        switch (tag) {
+        case tagId(DataKeywords::Design::Graph::Node::TEXT):
+            text = readFirstTextNodeContent(r);
+            return true;
+        case tagId(DataKeywords::Design::Graph::Node::COLOR):
+            node->setColor(readColorElement(r));
+            return true;
+        case tagId(DataKeywords::Design::Graph::Node::TEXT_COLOR):
+            node->setTextColor(readColorElement(r));
+            return true;
+        case tagId(DataKeywords::Design::Graph::Node::IMAGE):
+            node->setImageRef(readImageElement(r));
+            return true;
+        default:
+            return false;
+        }
+    });
+
+    node->setTextAndSize(text, size);
 
     return node;
 }
 
-static std::unique_ptr<Edge> readEdge(const QDomElement & element, MindMapData & data)
+std::unique_ptr<Edge> readEdge(QXmlStreamReader & reader, MindMapData & data)
+{
+    return readEdge(reader, [&data](int index) -> Node & {
+        return *data.graph().getNode(index);
+    });
+}
+
+std::unique_ptr<Edge> readEdge(QXmlStreamReader & reader, const std::function<Node &(int)> & getNode)
 {
-    const int index0 = element.attribute(DataKeywords::Design::Graph::Edge::INDEX0, "-1").toInt();
-    const int index1 = element.attribute(DataKeywords::Design::Graph::Edge::INDEX1, "-1").toInt();
-    const int reversed = element.attribute(DataKeywords::Design::Graph::Edge::REVERSED, "0").toInt();
-    const int arrowMode = element.attribute(DataKeywords::Design::Graph::Edge::ARROW_MODE, "0").toInt();
+    const auto attributes = reader.attributes();
+    const int index0 = readAttribute(attributes, DataKeywords::Design::Graph::Edge::INDEX0, "-1").toInt();
+    const int index1 = readAttribute(attributes, DataKeywords::Design::Graph::Edge::INDEX1, "-1").toInt();
+    const int reversed = readAttribute(attributes, DataKeywords::Design::Graph::Edge::REVERSED, "0").toInt();
+    const int arrowMode = readAttribute(attributes, DataKeywords::Design::Graph::Edge::ARROW_MODE, "0").toInt();
 
     // Initialize a new edge. QGraphicsScene will take the ownership eventually.
-    const auto node0 = data.graph().getNode(index0);
-    const auto node1 = data.graph().getNode(index1);
+    auto && node0 = getNode(index0);
+    auto && node1 = getNode(index1);
 
-    auto edge = std::make_unique<Edge>(*node0, *node1);
+    auto edge = std::make_unique<Edge>(node0, node1);
     edge->setArrowMode(static_cast<Edge::ArrowMode>(arrowMode));
     edge->setReversed(reversed);
 
-    readChildren(element, { { QString(DataKeywords::Design::Graph::Node::TEXT), [&edge](const QDomElement & e) {
-                                 edge->setText(readFirstTextNodeContent(e));
-                             } } });
+    readChildren(reader, [&edge](QXmlStreamReader & r, TagId tag) {
+        switch (tag) {
+        case tagId(DataKeywords::Design::Graph::Node::TEXT):
+            edge->setText(readFirstTextNodeContent(r));
+            return true;
+        default:
+            return false;
+        }
+    });
 
     return edge;
 }
 
-static void readLayoutOptimizer(const QDomElement & element, MindMapData & data)
+using PendingImages = std::vector<std::future<Image>>;
+
+static void readImage(QXmlStreamReader & reader, PendingImages & pendingImages)
+{
+    const auto attributes = reader.attributes();
+    const auto id = readAttribute(attributes, DataKeywords::Design::Image::ID).toUInt();
+    const auto path = readAttribute(attributes, DataKeywords::Design::Image::PATH).toStdString();
+    pendingImages.push_back(base64ToImage(readFirstTextNodeContent(reader).toLatin1(), id, path));
+}
+
+static void addPendingImages(PendingImages & pendingImages, MindMapData & data)
 {
-    double aspectRatio = element.attribute(DataKeywords::Design::LayoutOptimizer::ASPECT_RATIO, "-1").toDouble() / SCALE;
+    for (auto && pendingImage : pendingImages) {
+        data.imageManager().setImage(pendingImage.get());
+    }
+}
+
+static void readLayoutOptimizer(QXmlStreamReader & reader, MindMapData & data)
+{
+    const auto attributes = reader.attributes();
+
+    double aspectRatio = readAttribute(attributes, DataKeywords::Design::LayoutOptimizer::ASPECT_RATIO, "-1").toDouble() / SCALE;
     aspectRatio = std::min(aspectRatio, Constants::LayoutOptimizer::MAX_ASPECT_RATIO);
     aspectRatio = std::max(aspectRatio, Constants::LayoutOptimizer::MIN_ASPECT_RATIO);
     data.setAspectRatio(aspectRatio);
 
-    double minEdgeLength = element.attribute(DataKeywords::Design::LayoutOptimizer::MIN_EDGE_LENGTH, "-1").toDouble() / SCALE;
+    double minEdgeLength = readAttribute(attributes, DataKeywords::Design::LayoutOptimizer::MIN_EDGE_LENGTH, "-1").toDouble() / SCALE;
     minEdgeLength = std::min(minEdgeLength, Constants::LayoutOptimizer::MAX_EDGE_LENGTH);
     minEdgeLength = std::max(minEdgeLength, Constants::LayoutOptimizer::MIN_EDGE_LENGTH);
     data.setMinEdgeLength(minEdgeLength);
+
+    reader.skipCurrentElement();
+}
+
+static void readImageImport(QXmlStreamReader & reader, MindMapData & data)
+{
+    const auto attributes = reader.attributes();
+
+    ImageImportOptions options;
+    options.maxSize = readAttribute(attributes, DataKeywords::Design::ImageImport::MAX_SIZE, QString::number(options.maxSize)).toInt();
+    options.maxSize = std::min(std::max(options.maxSize, 0), Constants::ImageImport::MAX_MAX_SIZE);
+    options.format = readAttribute(attributes, DataKeywords::Design::ImageImport::FORMAT, options.format);
+    options.quality = readAttribute(attributes, DataKeywords::Design::ImageImport::QUALITY, QString::number(options.quality)).toInt();
+    options.quality = std::min(std::max(options.quality, -1), Constants::ImageImport::MAX_QUALITY);
+    data.setImageImportOptions(options);
+
+    reader.skipCurrentElement();
 }
 
-static void readGraph(const QDomElement & graph, MindMapData & data)
+static void readView(QXmlStreamReader & reader, MindMapData & data)
 {
-    readChildren(graph, {
-                          { QString(DataKeywords::Design::Graph::NODE), [&data](const QDomElement & e) {
-                               data.graph().addNode(readNode(e));
-                           } },
-                          { QString(DataKeywords::Design::Graph::EDGE), [&data](const QDomElement & e) {
-                               data.graph().addEdge(readEdge(e, data));
-                           } },
-                        });
+    const auto attributes = reader.attributes();
+    data.setViewRect({ readAttribute(attributes, DataKeywords::Design::View::X, "0").toInt() / SCALE,
+                       readAttribute(attributes, DataKeywords::Design::View::Y, "0").toInt() / SCALE,
+                       readAttribute(attributes, DataKeywords::Design::View::W, "0").toInt() / SCALE,
+                       readAttribute(attributes, DataKeywords::Design::View::H, "0").toInt() / SCALE });
+
+    reader.skipCurrentElement();
 }
 
-std::unique_ptr<MindMapData> fromXml(QDomDocument document)
+static void readGraph(QXmlStreamReader & reader, MindMapData & data)
+{
+    readChildren(reader, [&data](QXmlStreamReader & r, TagId tag) {
+        switch (tag) {
+        case tagId(DataKeywords::Design::Graph::NODE):
+            data.graph().addNode(readNode(r));
+            return true;
+        case tagId(DataKeywords::Design::Graph::EDGE):
+            data.graph().addEdge(readEdge(r, data));
+            return true;
+        default:
+            return false;
+        }
+    });
+}
+
+std::unique_ptr<MindMapData> fromXml(QXmlStreamReader & reader)
 {
-    const auto design = document.documentElement();
     auto data = std::make_unique<MindMapData>();
-    data->setVersion(design.attribute(DataKeywords::Design::APPLICATION_VERSION, "UNDEFINED"));
-
-    readChildren(design, { { QString(DataKeywords::Design::GRAPH), [&data](const QDomElement & e) {
-                                readGraph(e, *data);
-                            } },
-                           { QString(DataKeywords::Design::COLOR), [&data](const QDomElement & e) {
-                                data->setBackgroundColor(readColorElement(e));
-                            } },
-                           { QString(DataKeywords::Design::EDGE_COLOR), [&data](const QDomElement & e) {
-                                data->setEdgeColor(readColorElement(e));
-                            } },
-                           { QString(DataKeywords::Design::GRID_COLOR), [&data](const QDomElement & e) {
-                                data->setGridColor(readColorElement(e));
-                            } },
-                           { QString(DataKeywords::Design::EDGE_THICKNESS), [&data](const QDomElement & e) {
-                                data->setEdgeWidth(readFirstTextNodeContent(e).toDouble() / SCALE);
-                            } },
-                           { QString(DataKeywords::Design::IMAGE), [&data](const QDomElement & e) {
-                                const auto id = e.attribute(DataKeywords::Design::Image::ID).toUInt();
-                                const auto path = e.attribute(DataKeywords::Design::Image::PATH).toStdString();
-                                Image image(base64ToQImage(readFirstTextNodeContent(e).toStdString(), id, path), path);
-                                image.setId(id);
-                                data->imageManager().setImage(image);
-                            } },
-                           { QString(DataKeywords::Design::TEXT_SIZE), [&data](const QDomElement & e) {
-                                data->setTextSize(static_cast<int>(readFirstTextNodeContent(e).toDouble() / SCALE));
-                            } },
-                           { QString(DataKeywords::Design::CORNER_RADIUS), [&data](const QDomElement & e) {
-                                data->setCornerRadius(static_cast<int>(readFirstTextNodeContent(e).toDouble() / SCALE));
-                            } },
-                           { QString(DataKeywords::Design::LayoutOptimizer::LAYOUT_OPTIMIZER), [&data](const QDomElement & e) {
-                                readLayoutOptimizer(e, *data);
-                            } } });
+    if (!reader.readNextStartElement()) {
+        return data;
+    }
+
+    data->setVersion(readAttribute(reader.attributes(), DataKeywords::Design::APPLICATION_VERSION, "UNDEFINED"));
+
+    PendingImages pendingImages;
+
+    readChildren(reader, [&data, &pendingImages](QXmlStreamReader & r, TagId tag) {
+        switch (tag) {
+        case tagId(DataKeywords::Design::GRAPH):
+            readGraph(r, *data);
+            return true;
+        case tagId(DataKeywords::Design::COLOR):
+            data->setBackgroundColor(readColorElement(r));
+            return true;
+        case tagId(DataKeywords::Design::EDGE_COLOR):
+            data->setEdgeColor(readColorElement(r));
+            return true;
+        case tagId(DataKeywords::Design::GRID_COLOR):
+            data->setGridColor(readColorElement(r));
+            return true;
+        case tagId(DataKeywords::Design::EDGE_THICKNESS):
+            data->setEdgeWidth(readFirstTextNodeContent(r).toDouble() / SCALE);
+            return true;
+        case tagId(DataKeywords::Design::IMAGE):
+            readImage(r, pendingImages);
+            return true;
+        case tagId(DataKeywords::Design::TEXT_SIZE):
+            data->setTextSize(static_cast<int>(readFirstTextNodeContent(r).toDouble() / SCALE));
+            return true;
+        case tagId(DataKeywords::Design::CORNER_RADIUS):
+            data->setCornerRadius(static_cast<int>(readFirstTextNodeContent(r).toDouble() / SCALE));
+            return true;
+        case tagId(DataKeywords::Design::ImageImport::IMAGE_IMPORT):
+            readImageImport(r, *data);
+            return true;
+        case tagId(DataKeywords::Design::LayoutOptimizer::LAYOUT_OPTIMIZER):
+            readLayoutOptimizer(r, *data);
+            return true;
+        case tagId(DataKeywords::Design::View::VIEW):
+            readView(r, *data);
+            return true;
+        default:
+            return false;
+        }
+    });
+
+    addPendingImages(pendingImages, *data);
+
+    return data;
+}
+
+std::unique_ptr<MindMapData> fromXml(const QByteArray & xml)
+{
+    QXmlStreamReader reader(xml);
+    return fromXml(reader);
+}
+
+// Plain-data counterparts of Node and Edge so that graph chunks can be parsed off the GUI thread
+struct NodeRecord
+{
+    int index = -1;
+
+    QPointF location;
+
+    QSizeF size;
+
+    bool hasSize = false;
+
+    QString text;
+
+    QColor color; // Invalid if not present
+
+    QColor textColor; // Invalid if not present
+
+    size_t imageRef = 0;
+};
+
+struct EdgeRecord
+{
+    int index0 = -1;
+
+    int index1 = -1;
+
+    int arrowMode = 0;
+
+    bool reversed = false;
+
+    QString text;
+};
+
+struct GraphChunk
+{
+    std::vector<NodeRecord> nodes;
+
+    std::vector<EdgeRecord> edges;
+};
+
+static NodeRecord readNodeRecord(QXmlStreamReader & reader)
+{
+    NodeRecord record;
+
+    const auto attributes = reader.attributes();
+    record.index = readAttribute(attributes, DataKeywords::Design::Graph::Node::INDEX, "-1").toInt();
+    record.location = QPointF(
+      readAttribute(attributes, DataKeywords::Design::Graph::Node::X, "0").toInt() / SCALE,
+      readAttribute(attributes, DataKeywords::Design::Graph::Node::Y, "0").toInt() / SCALE);
+
+    if (attributes.hasAttribute(QLatin1String(DataKeywords::Design::Graph::Node::W)) && attributes.hasAttribute(QLatin1String(DataKeywords::Design::Graph::Node::H))) {
+        record.hasSize = true;
+        record.size = QSizeF(
+          readAttribute(attributes, DataKeywords::Design::Graph::Node::W).toInt() / SCALE,
+          readAttribute(attributes, DataKeywords::Design::Graph::Node::H).toInt() / SCALE);
+    }
+
+    readChildren(reader, [&record](QXmlStreamReader & r, TagId tag) {
+        switch (tag) {
+        case tagId(DataKeywords::Design::Graph::Node::TEXT):
+            record.text = readFirstTextNodeContent(r);
+            return true;
+        case tagId(DataKeywords::Design::Graph::Node::COLOR):
+            record.color = readColorElement(r);
+            return true;
+        case tagId(DataKeywords::Design::Graph::Node::TEXT_COLOR):
+            record.textColor = readColorElement(r);
+            return true;
+        case tagId(DataKeywords::Design::Graph::Node::IMAGE):
+            record.imageRef = readImageElement(r);
+            return true;
+        default:
+            return false;
+        }
+    });
+
+    return record;
+}
+
+static EdgeRecord readEdgeRecord(QXmlStreamReader & reader)
+{
+    EdgeRecord record;
+
+    const auto attributes = reader.attributes();
+    record.index0 = readAttribute(attributes, DataKeywords::Design::Graph::Edge::INDEX0, "-1").toInt();
+    record.index1 = readAttribute(attributes, DataKeywords::Design::Graph::Edge::INDEX1, "-1").toInt();
+    record.reversed = readAttribute(attributes, DataKeywords::Design::Graph::Edge::REVERSED, "0").toInt();
+    record.arrowMode = readAttribute(attributes, DataKeywords::Design::Graph::Edge::ARROW_MODE, "0").toInt();
+
+    readChildren(reader, [&record](QXmlStreamReader & r, TagId tag) {
+        switch (tag) {
+        case tagId(DataKeywords::Design::Graph::Node::TEXT):
+            record.text = readFirstTextNodeContent(r);
+            return true;
+        default:
+            return false;
+        }
+    });
+
+    return record;
+}
+
+static void throwIfError(const QXmlStreamReader & reader)
+{
+    if (reader.hasError()) {
+        throw std::runtime_error("XML error at line " + std::to_string(reader.lineNumber()) + ": " + reader.errorString().toStdString());
+    }
+}
 
+static GraphChunk parseGraphChunk(QByteArray chunk)
+{
+    GraphChunk graphChunk;
+    QXmlStreamReader reader(chunk);
+    if (reader.readNextStartElement()) {
+        readChildren(reader, [&graphChunk](QXmlStreamReader & r, TagId tag) {
+            switch (tag) {
+            case tagId(DataKeywords::Design::Graph::NODE):
+                graphChunk.nodes.push_back(readNodeRecord(r));
+                return true;
+            case tagId(DataKeywords::Design::Graph::EDGE):
+                graphChunk.edges.push_back(readEdgeRecord(r));
+                return true;
+            default:
+                return false;
+            }
+        });
+    }
+    throwIfError(reader);
+    return graphChunk;
+}
+
+static std::unique_ptr<MindMapData> fromXmlChecked(QXmlStreamReader & reader)
+{
+    auto data = fromXml(reader);
+    throwIfError(reader);
     return data;
 }
 
-QDomDocument toXml(MindMapData & mindMapData)
+static std::unique_ptr<MindMapData> fromXmlChecked(const QByteArray & xml)
 {
-    QDomDocument doc;
+    QXmlStreamReader reader(xml);
+    return fromXmlChecked(reader);
+}
 
-    doc.appendChild(doc.createProcessingInstruction("xml", "version='1.0' encoding='UTF-8'"));
+// Reads two parts of a buffer one after the other without joining them into a new buffer
+class JoinedDevice : public QIODevice
+{
+public:
+    JoinedDevice(QByteArray first, QByteArray second)
+      : m_first(first)
+      , m_second(second)
+    {
+        open(QIODevice::ReadOnly);
+    }
 
-    auto design = doc.createElement(DataKeywords::Design::DESIGN);
-    design.setAttribute(DataKeywords::Design::APPLICATION_VERSION, Constants::Application::APPLICATION_VERSION);
-    doc.appendChild(design);
+    bool isSequential() const override
+    {
+        return true;
+    }
 
-    writeColor(design, doc, mindMapData.backgroundColor(), DataKeywords::Design::COLOR);
+    qint64 bytesAvailable() const override
+    {
+        return m_first.size() + m_second.size() - m_pos + QIODevice::bytesAvailable();
+    }
 
-    writeColor(design, doc, mindMapData.edgeColor(), DataKeywords::Design::EDGE_COLOR);
+protected:
+    qint64 readData(char * data, qint64 maxSize) override
+    {
+        qint64 count = 0;
+        while (count < maxSize && m_pos < m_first.size() + m_second.size()) {
+            const auto & part = m_pos < m_first.size() ? m_first : m_second;
+            const auto offset = m_pos < m_first.size() ? m_pos : m_pos - m_first.size();
+            const auto size = std::min(maxSize - count, part.size() - offset);
+            std::memcpy(data + count, part.constData() + offset, static_cast<size_t>(size));
+            count += size;
+            m_pos += size;
+        }
+        return count;
+    }
+
+    qint64 writeData(const char *, qint64) override
+    {
+        return -1;
+    }
+
+private:
+    QByteArray m_first;
+
+    QByteArray m_second;
+
+    qint64 m_pos = 0;
+};
 
-    writeColor(design, doc, mindMapData.gridColor(), DataKeywords::Design::GRID_COLOR);
+// Finds the next element of the graph body that can start a chunk. Text content cannot contain a raw '<',
+// so a match is always a real start tag of a direct child of <graph>.
+static int findChunkStart(const QByteArray & xml, int from, int end)
+{
+    const auto nodeStart = xml.indexOf(QByteArray("<") + DataKeywords::Design::Graph::NODE + " ", from);
+    const auto edgeStart = xml.indexOf(QByteArray("<") + DataKeywords::Design::Graph::EDGE + " ", from);
+    int start = end;
+    if (nodeStart >= 0) {
+        start = std::min(start, nodeStart);
+    }
+    if (edgeStart >= 0) {
+        start = std::min(start, edgeStart);
+    }
+    return start;
+}
 
-    auto edgeWidthElement = doc.createElement(DataKeywords::Design::EDGE_THICKNESS);
-    edgeWidthElement.appendChild(doc.createTextNode(QString::number(static_cast<int>(mindMapData.edgeWidth() * SCALE))));
-    design.appendChild(edgeWidthElement);
+std::unique_ptr<MindMapData> fromXmlParallel(const QByteArray & xml, int minChunkSize)
+{
+    minChunkSize = std::max(minChunkSize, 1);
+
+    // Locate the body of <graph>...</graph>
+    const auto graphTag = QByteArray("<") + DataKeywords::Design::GRAPH;
+    const auto graphStart = xml.indexOf(graphTag + ">");
+    const auto bodyStart = graphStart >= 0 ? graphStart + graphTag.size() + 1 : -1;
+    const auto bodyEnd = bodyStart >= 0 ? xml.indexOf("</" + QByteArray(DataKeywords::Design::GRAPH) + ">", bodyStart) : -1;
+    if (bodyEnd < 0 || bodyEnd - bodyStart < 2 * minChunkSize) {
+        return fromXmlChecked(xml);
+    }
 
-    auto textSizeElement = doc.createElement(DataKeywords::Design::TEXT_SIZE);
-    textSizeElement.appendChild(doc.createTextNode(QString::number(static_cast<int>(mindMapData.textSize() * SCALE))));
-    design.appendChild(textSizeElement);
+    // Split the body at element boundaries and parse the chunks on the worker pool
+    std::vector<std::future<GraphChunk>> chunks;
+    const auto graphStartTag = graphTag + ">";
+    const auto graphEndTag = "</" + QByteArray(DataKeywords::Design::GRAPH) + ">";
+    int chunkStart = bodyStart;
+    while (chunkStart < bodyEnd) {
+        const auto chunkEnd = findChunkStart(xml, std::min(chunkStart + minChunkSize, bodyEnd), bodyEnd);
+        const auto chunk = graphStartTag + xml.mid(chunkStart, chunkEnd - chunkStart) + graphEndTag;
+        chunks.push_back(WorkerPool::run([chunk] {
+            return parseGraphChunk(chunk);
+        }));
+        chunkStart = chunkEnd;
+    }
 
-    auto cornerRadiusElement = doc.createElement(DataKeywords::Design::CORNER_RADIUS);
-    cornerRadiusElement.appendChild(doc.createTextNode(QString::number(static_cast<int>(mindMapData.cornerRadius() * SCALE))));
-    design.appendChild(cornerRadiusElement);
+    juzzlin::L().debug() << "Parsing graph in " << chunks.size() << " chunks";
 
-    auto graph = doc.createElement(DataKeywords::Design::GRAPH);
-    design.appendChild(graph);
+    // Meanwhile parse everything else with the reference parser. Most of it is usually embedded images,
+    // so it's read in place and not copied.
+    JoinedDevice outsideGraph(QByteArray::fromRawData(xml.constData(), bodyStart), QByteArray::fromRawData(xml.constData() + bodyEnd, xml.size() - bodyEnd));
+    QXmlStreamReader outsideGraphReader(&outsideGraph);
+    auto data = fromXmlChecked(outsideGraphReader);
 
-    writeNodes(mindMapData, graph, doc);
+    // Build the graph in document order: all nodes first, as edges refer to them
+    std::vector<GraphChunk> graphChunks;
+    for (auto && chunk : chunks) {
+        graphChunks.push_back(chunk.get());
+    }
 
-    writeEdges(mindMapData, graph, doc);
+    std::map<int, NodePtr> nodes;
+    for (auto && graphChunk : graphChunks) {
+        for (auto && record : graphChunk.nodes) {
+            // Init a new node. QGraphicsScene will take the ownership eventually.
+            auto node = std::make_shared<Node>();
+            node->setIndex(record.index);
+            node->setLocation(record.location);
+            node->setTextAndSize(record.text, record.hasSize ? record.size : QSizeF());
+            if (record.color.isValid()) {
+                node->setColor(record.color);
+            }
+            if (record.textColor.isValid()) {
+                node->setTextColor(record.textColor);
+            }
+            node->setImageRef(record.imageRef);
+            data->graph().addNode(node);
+            nodes.emplace(node->index(), node);
+        }
+    }
 
-    writeImages(mindMapData, design, doc);
+    for (auto && graphChunk : graphChunks) {
+        for (auto && record : graphChunk.edges) {
+            const auto node0 = nodes.find(record.index0);
+            const auto node1 = nodes.find(record.index1);
+            if (node0 == nodes.end() || node1 == nodes.end()) {
+                throw std::runtime_error("Edge refers to a missing node: " + std::to_string(record.index0) + " -> " + std::to_string(record.index1));
+            }
+            // Initialize a new edge. QGraphicsScene will take the ownership eventually.
+            auto edge = std::make_shared<Edge>(*node0->second, *node1->second);
+            edge->setArrowMode(static_cast<Edge::ArrowMode>(record.arrowMode));
+            edge->setReversed(record.reversed);
+            edge->setText(record.text);
+            data->graph().addEdge(edge);
+        }
+    }
 
-    writeLayoutOptimizer(mindMapData, design, doc);
+    return data;
+}
 
-    return doc;
+void toXml(const MindMapState & state, QXmlStreamWriter & writer)
+{
+    writer.writeStartDocument();
+
+    writer.writeStartElement(DataKeywords::Design::DESIGN);
+    writer.writeAttribute(DataKeywords::Design::APPLICATION_VERSION, Constants::Application::APPLICATION_VERSION);
+
+    writeColor(writer, state.design.backgroundColor, DataKeywords::Design::COLOR);
+
+    writeColor(writer, state.design.edgeColor, DataKeywords::Design::EDGE_COLOR);
+
+    writeColor(writer, state.design.gridColor, DataKeywords::Design::GRID_COLOR);
+
+    writer.writeTextElement(DataKeywords::Design::EDGE_THICKNESS, QString::number(static_cast<int>(state.design.edgeWidth * SCALE)));
+
+    writer.writeTextElement(DataKeywords::Design::TEXT_SIZE, QString::number(static_cast<int>(state.design.textSize * SCALE)));
+
+    writer.writeTextElement(DataKeywords::Design::CORNER_RADIUS, QString::number(static_cast<int>(state.design.cornerRadius * SCALE)));
+
+    writer.writeStartElement(DataKeywords::Design::GRAPH);
+
+    writeNodes(state, writer);
+
+    writeEdges(state, writer);
+
+    writer.writeEndElement();
+
+    writeImages(state, writer);
+
+    writeLayoutOptimizer(state, writer);
+
+    writeImageImport(state, writer);
+
+    writeView(state, writer);
+
+    writer.writeEndElement();
+
+    writer.writeEndDocument();
+}
+
+QByteArray toXml(const MindMapState & state)
+{
+    QByteArray xml;
+    QXmlStreamWriter writer(&xml);
+    writer.setAutoFormatting(true);
+    toXml(state, writer);
+    return xml;
+}
+
+QByteArray toXml(const MindMapData & mindMapData)
+{
+    return toXml(MindMapState::captureForSaving(mindMapData));
 }
 
 } // namespace AlzSerializer
@@ -16,17 +16,50 @@
 #ifndef ALZ_SERIALIZER_HPP
 #define ALZ_SERIALIZER_HPP
 
-#include <QDomDocument>
+#include "mind_map_state.hpp"
 
+#include <QByteArray>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include <functional>
 #include <memory>
 
+class Edge;
 class MindMapData;
+class Node;
 
 namespace AlzSerializer {
 
-std::unique_ptr<MindMapData> fromXml(QDomDocument document);
+std::unique_ptr<MindMapData> fromXml(const QByteArray & xml);
+
+//! Builds the mind map in a single pass while the reader streams through the document.
+std::unique_ptr<MindMapData> fromXml(QXmlStreamReader & reader);
+
+//! Parses the graph in chunks of at least minChunkSize bytes on the worker pool and builds the
+//! result in document order. Gives the same result as fromXml(), but throws std::runtime_error on malformed input.
+std::unique_ptr<MindMapData> fromXmlParallel(const QByteArray & xml, int minChunkSize);
+
+//! Emits the mind map element by element so that no intermediate document is built.
+//! Only plain data is accessed, so the state can be written on a worker thread.
+void toXml(const MindMapState & state, QXmlStreamWriter & writer);
+
+QByteArray toXml(const MindMapState & state);
+
+QByteArray toXml(const MindMapData & mindMapData);
+
+//! Element level access used by AlzJournal. Elements use the same format as in <graph>.
+void writeNode(const MindMapState & state, const MindMapState::NodeState & node, QXmlStreamWriter & writer);
+
+void writeEdge(const MindMapState::EdgeState & edge, QXmlStreamWriter & writer);
+
+std::unique_ptr<Node> readNode(QXmlStreamReader & reader);
+
+//! Throws std::runtime_error if the connected nodes don't exist.
+std::unique_ptr<Edge> readEdge(QXmlStreamReader & reader, MindMapData & data);
 
-QDomDocument toXml(MindMapData & mindMapData);
+//! Connects the nodes returned by getNode, which throws std::runtime_error if a node doesn't exist.
+std::unique_ptr<Edge> readEdge(QXmlStreamReader & reader, const std::function<Node &(int)> & getNode);
 
 } // namespace AlzSerializer
 
@@ -0,0 +1,642 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "alzb_serializer.hpp"
+
+#include "constants.hpp"
+#include "file_exception.hpp"
+#include "graph.hpp"
+#include "mind_map_data.hpp"
+#include "mind_map_state.hpp"
+#include "node.hpp"
+#include "simple_logger.hpp"
+#include "test_mode.hpp"
+#include "worker_pool.hpp"
+
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace AlzbSerializer {
+
+static const char MAGIC[MAGIC_SIZE] = { 'A', 'L', 'Z', 'B' };
+
+static const quint32 FORMAT_VERSION = 2;
+
+static const quint32 VIEW_FORMAT_VERSION = 2; // First version that stores the view
+
+static const quint64 HEADER_SIZE_V1 = 136;
+
+static const double SCALE = 1000; // Same fixed-point scale as in the XML format to keep the conversion loss-free
+
+static const qint64 COPY_CHUNK_SIZE = 64 * 1024;
+
+// All records are stored in little-endian byte order and are accessed in place
+
+struct StringRef
+{
+    quint32 offset;
+
+    quint32 size;
+};
+
+struct Header
+{
+    char magic[MAGIC_SIZE];
+
+    quint32 formatVersion;
+
+    StringRef applicationVersion;
+
+    quint32 backgroundColor;
+
+    quint32 edgeColor;
+
+    quint32 gridColor;
+
+    qint32 edgeWidth;
+
+    qint32 textSize;
+
+    qint32 cornerRadius;
+
+    quint64 aspectRatio; // IEEE 754 bits
+
+    quint64 minEdgeLength; // IEEE 754 bits
+
+    quint32 nodeCount;
+
+    quint32 edgeCount;
+
+    quint32 imageCount;
+
+    quint32 imageMaxSize;
+
+    quint64 nodeOffset;
+
+    quint64 edgeOffset;
+
+    quint64 imageOffset;
+
+    quint64 stringTableOffset;
+
+    quint64 stringTableSize;
+
+    quint64 blobOffset;
+
+    qint32 imageQuality;
+
+    quint32 reserved;
+
+    StringRef imageFormat;
+
+    // Since version 2, empty if no view was saved
+    qint32 viewX;
+
+    qint32 viewY;
+
+    qint32 viewW;
+
+    qint32 viewH;
+};
+
+struct NodeRecord
+{
+    qint32 index;
+
+    qint32 x;
+
+    qint32 y;
+
+    qint32 w;
+
+    qint32 h;
+
+    quint32 color;
+
+    quint32 textColor;
+
+    quint32 imageRef;
+
+    StringRef text;
+};
+
+struct EdgeRecord
+{
+    qint32 index0;
+
+    qint32 index1;
+
+    quint32 arrowMode;
+
+    quint32 reversed;
+
+    StringRef text;
+};
+
+struct ImageRecord
+{
+    quint32 id;
+
+    StringRef path;
+
+    quint32 reserved;
+
+    quint64 blobOffset; // Relative to Header::blobOffset
+
+    quint64 blobSize;
+};
+
+static_assert(sizeof(StringRef) == 8, "Unexpected padding in StringRef");
+static_assert(sizeof(Header) == 152, "Unexpected padding in Header");
+static_assert(sizeof(NodeRecord) == 40, "Unexpected padding in NodeRecord");
+static_assert(sizeof(EdgeRecord) == 24, "Unexpected padding in EdgeRecord");
+static_assert(sizeof(ImageRecord) == 32, "Unexpected padding in ImageRecord");
+
+// Byte order conversion is symmetric, so the same helper works in both directions
+template<typename T>
+static T le(T value)
+{
+    return qToLittleEndian(value);
+}
+
+static quint64 doubleToBits(double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return le(bits);
+}
+
+static double bitsToDouble(quint64 bits)
+{
+    bits = le(bits);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static quint64 align(quint64 offset)
+{
+    return (offset + 7) & ~quint64 { 7 };
+}
+
+class StringTable
+{
+public:
+    StringRef add(const QString & string)
+    {
+        const auto utf8 = string.toUtf8();
+        const StringRef ref { le(static_cast<quint32>(m_data.size())), le(static_cast<quint32>(utf8.size())) };
+        m_data.append(utf8);
+        return ref;
+    }
+
+    const QByteArray & data() const
+    {
+        return m_data;
+    }
+
+private:
+    QByteArray m_data;
+};
+
+static qint32 scaled(double value)
+{
+    return le(static_cast<qint32>(value * SCALE));
+}
+
+static quint32 rgb(const QColor & color)
+{
+    return le(static_cast<quint32>(color.rgb()));
+}
+
+static std::vector<Image> usedImages(const MindMapState & state)
+{
+    std::vector<Image> images;
+    std::set<size_t> ids;
+    for (auto && node : state.nodes) {
+        const auto image = state.images.find(node.imageRef);
+        if (image != state.images.end() && ids.insert(image->second.id()).second) {
+            images.push_back(image->second);
+        }
+    }
+    return images;
+}
+
+static size_t canonicalImageRef(const MindMapState & state, size_t imageRef)
+{
+    const auto image = state.images.find(imageRef);
+    return image != state.images.end() ? image->second.id() : imageRef;
+}
+
+static quint64 blobSize(const Image & image)
+{
+    if (!image.data().isEmpty()) {
+        return static_cast<quint64>(image.data().size());
+    } else if (!TestMode::enabled()) {
+        QFileInfo info(image.path().c_str());
+        if (!info.exists()) {
+            throw std::runtime_error("Cannot open file: '" + image.path() + "'");
+        }
+        return static_cast<quint64>(info.size());
+    } else {
+        TestMode::logDisabledCode("blobSize");
+        return 0;
+    }
+}
+
+static void writePadding(QIODevice & device, quint64 from, quint64 to)
+{
+    const QByteArray padding(static_cast<int>(to - from), 0);
+    device.write(padding);
+}
+
+static void writeBlob(QIODevice & device, const Image & image, quint64 size)
+{
+    if (!image.data().isEmpty()) {
+        device.write(image.data());
+    } else if (!TestMode::enabled()) {
+        QFile in(image.path().c_str());
+        if (!in.open(QIODevice::ReadOnly)) {
+            throw std::runtime_error("Cannot open file: '" + image.path() + "'");
+        }
+        quint64 copied = 0;
+        while (copied < size) {
+            const auto chunk = in.read(std::min(COPY_CHUNK_SIZE, static_cast<qint64>(size - copied)));
+            if (chunk.isEmpty()) {
+                break;
+            }
+            device.write(chunk);
+            copied += static_cast<quint64>(chunk.size());
+        }
+        if (copied != size || !in.atEnd()) {
+            throw std::runtime_error("File changed while saving: '" + image.path() + "'");
+        }
+    } else {
+        TestMode::logDisabledCode("writeBlob");
+    }
+}
+
+void toBinary(const MindMapState & state, QIODevice & device)
+{
+    StringTable strings;
+
+    std::vector<NodeRecord> nodes;
+    for (auto && node : state.nodes) {
+        nodes.push_back({ le(static_cast<qint32>(node.index)),
+                          scaled(node.location.x()),
+                          scaled(node.location.y()),
+                          scaled(node.size.width()),
+                          scaled(node.size.height()),
+                          rgb(node.color),
+                          rgb(node.textColor),
+                          le(static_cast<quint32>(canonicalImageRef(state, node.imageRef))),
+                          strings.add(node.text) });
+    }
+
+    std::vector<EdgeRecord> edges;
+    for (auto && edge : state.edges) {
+        edges.push_back({ le(static_cast<qint32>(edge.index0)),
+                          le(static_cast<qint32>(edge.index1)),
+                          le(static_cast<quint32>(edge.arrowMode)),
+                          le(static_cast<quint32>(edge.reversed)),
+                          strings.add(edge.text) });
+    }
+
+    const auto imageList = usedImages(state);
+    std::vector<ImageRecord> images;
+    std::vector<quint64> blobSizes;
+    quint64 blobOffset = 0;
+    for (auto && image : imageList) {
+        const auto size = blobSize(image);
+        images.push_back({ le(static_cast<quint32>(image.id())), strings.add(image.path().c_str()), 0, le(blobOffset), le(size) });
+        blobSizes.push_back(size);
+        blobOffset += size;
+    }
+
+    Header header {};
+    std::memcpy(header.magic, MAGIC, MAGIC_SIZE);
+    header.formatVersion = le(FORMAT_VERSION);
+    header.applicationVersion = strings.add(Constants::Application::APPLICATION_VERSION);
+    header.backgroundColor = rgb(state.design.backgroundColor);
+    header.edgeColor = rgb(state.design.edgeColor);
+    header.gridColor = rgb(state.design.gridColor);
+    header.edgeWidth = scaled(state.design.edgeWidth);
+    header.textSize = scaled(state.design.textSize);
+    header.cornerRadius = scaled(state.design.cornerRadius);
+    header.aspectRatio = doubleToBits(state.design.aspectRatio);
+    header.minEdgeLength = doubleToBits(state.design.minEdgeLength);
+    const auto imageImportOptions = state.design.imageImportOptions;
+    header.imageMaxSize = le(static_cast<quint32>(imageImportOptions.maxSize));
+    header.imageQuality = le(static_cast<qint32>(imageImportOptions.quality));
+    header.imageFormat = strings.add(imageImportOptions.format);
+    if (state.viewRect.isValid()) {
+        header.viewX = scaled(state.viewRect.x());
+        header.viewY = scaled(state.viewRect.y());
+        header.viewW = scaled(state.viewRect.width());
+        header.viewH = scaled(state.viewRect.height());
+    }
+    header.nodeCount = le(static_cast<quint32>(nodes.size()));
+    header.edgeCount = le(static_cast<quint32>(edges.size()));
+    header.imageCount = le(static_cast<quint32>(images.size()));
+
+    const quint64 nodeOffset = align(sizeof(Header));
+    const quint64 edgeOffset = align(nodeOffset + nodes.size() * sizeof(NodeRecord));
+    const quint64 imageOffset = align(edgeOffset + edges.size() * sizeof(EdgeRecord));
+    const quint64 stringTableOffset = align(imageOffset + images.size() * sizeof(ImageRecord));
+    const quint64 stringTableSize = static_cast<quint64>(strings.data().size());
+    const quint64 blobSectionOffset = align(stringTableOffset + stringTableSize);
+    header.nodeOffset = le(nodeOffset);
+    header.edgeOffset = le(edgeOffset);
+    header.imageOffset = le(imageOffset);
+    header.stringTableOffset = le(stringTableOffset);
+    header.stringTableSize = le(stringTableSize);
+    header.blobOffset = le(blobSectionOffset);
+
+    device.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+    writePadding(device, sizeof(Header), nodeOffset);
+    device.write(reinterpret_cast<const char *>(nodes.data()), static_cast<qint64>(nodes.size() * sizeof(NodeRecord)));
+    writePadding(device, nodeOffset + nodes.size() * sizeof(NodeRecord), edgeOffset);
+    device.write(reinterpret_cast<const char *>(edges.data()), static_cast<qint64>(edges.size() * sizeof(EdgeRecord)));
+    writePadding(device, edgeOffset + edges.size() * sizeof(EdgeRecord), imageOffset);
+    device.write(reinterpret_cast<const char *>(images.data()), static_cast<qint64>(images.size() * sizeof(ImageRecord)));
+    writePadding(device, imageOffset + images.size() * sizeof(ImageRecord), stringTableOffset);
+    device.write(strings.data());
+    writePadding(device, stringTableOffset + stringTableSize, blobSectionOffset);
+
+    for (size_t i = 0; i < imageList.size(); i++) {
+        writeBlob(device, imageList.at(i), blobSizes.at(i));
+    }
+}
+
+QByteArray toBinary(const MindMapData & mindMapData)
+{
+    QByteArray binary;
+    QBuffer buffer(&binary);
+    buffer.open(QIODevice::WriteOnly);
+    toBinary(MindMapState::captureForSaving(mindMapData), buffer);
+    return binary;
+}
+
+bool isBinary(const QByteArray & header)
+{
+    return header.size() >= MAGIC_SIZE && std::memcmp(header.constData(), MAGIC, MAGIC_SIZE) == 0;
+}
+
+class Reader
+{
+public:
+    Reader(const char * data, qint64 size)
+      : m_data(data)
+      , m_size(static_cast<quint64>(size))
+    {
+        if (size < static_cast<qint64>(HEADER_SIZE_V1) || !isBinary(QByteArray::fromRawData(data, MAGIC_SIZE))) {
+            throw std::runtime_error("Not a binary mind map");
+        }
+        m_header = reinterpret_cast<const Header *>(data);
+        if (le(m_header->formatVersion) > FORMAT_VERSION) {
+            throw std::runtime_error("Unsupported binary mind map version " + std::to_string(le(m_header->formatVersion)));
+        }
+        if (hasView() && size < static_cast<qint64>(sizeof(Header))) {
+            throw std::runtime_error("Truncated binary mind map header");
+        }
+    }
+
+    const Header & header() const
+    {
+        return *m_header;
+    }
+
+    //! Version 1 headers end before the view fields.
+    bool hasView() const
+    {
+        return le(m_header->formatVersion) >= VIEW_FORMAT_VERSION;
+    }
+
+    template<typename T>
+    const T * records(quint64 offset, quint32 count) const
+    {
+        check(offset, static_cast<quint64>(count) * sizeof(T));
+        if (offset % alignof(T)) {
+            throw std::runtime_error("Misaligned record array");
+        }
+        return reinterpret_cast<const T *>(m_data + offset);
+    }
+
+    QString string(StringRef ref) const
+    {
+        const auto offset = le(m_header->stringTableOffset);
+        const auto size = le(m_header->stringTableSize);
+        if (static_cast<quint64>(le(ref.offset)) + le(ref.size) > size) {
+            throw std::runtime_error("String out of bounds");
+        }
+        check(offset, size);
+        return QString::fromUtf8(m_data + offset + le(ref.offset), static_cast<int>(le(ref.size)));
+    }
+
+    QByteArray blob(const ImageRecord & record) const
+    {
+        const auto offset = le(m_header->blobOffset) + le(record.blobOffset);
+        const auto size = le(record.blobSize);
+        check(offset, size);
+        return QByteArray::fromRawData(m_data + offset, static_cast<int>(size));
+    }
+
+private:
+    void check(quint64 offset, quint64 size) const
+    {
+        if (offset > m_size || size > m_size - offset || size > static_cast<quint64>(std::numeric_limits<int>::max())) {
+            throw std::runtime_error("Corrupted binary mind map");
+        }
+    }
+
+    const char * m_data;
+
+    quint64 m_size;
+
+    const Header * m_header = nullptr;
+};
+
+static QColor color(quint32 rgb)
+{
+    return QColor(static_cast<QRgb>(le(rgb)));
+}
+
+static double unscaled(qint32 value)
+{
+    return le(value) / SCALE;
+}
+
+// Copying and hashing happen on the worker pool. The blob refers to the caller's buffer,
+// so every job must be finished before that buffer goes away.
+static std::future<Image> extractImage(const QByteArray & blob, size_t imageId, std::string imagePath)
+{
+    return WorkerPool::run([blob, imageId, imagePath] {
+        juzzlin::L().debug() << "Extracting embedded image id=" << imageId << ", " << blob.size() << " bytes";
+        Image image(QByteArray(blob.constData(), blob.size()), imagePath); // Deep copy, the blob may point to a mapped file
+        image.setId(imageId);
+        return image;
+    });
+}
+
+static void waitAll(std::vector<std::future<Image>> & extractedImages)
+{
+    for (auto && extractedImage : extractedImages) {
+        if (extractedImage.valid()) {
+            extractedImage.wait();
+        }
+    }
+}
+
+std::unique_ptr<MindMapData> fromBinary(const char * data, qint64 size)
+{
+    const Reader reader(data, size);
+    const auto & header = reader.header();
+
+    auto mindMapData = std::make_unique<MindMapData>();
+    mindMapData->setVersion(reader.string(header.applicationVersion));
+    mindMapData->setBackgroundColor(color(header.backgroundColor));
+    mindMapData->setEdgeColor(color(header.edgeColor));
+    mindMapData->setGridColor(color(header.gridColor));
+    mindMapData->setEdgeWidth(unscaled(header.edgeWidth));
+    mindMapData->setTextSize(static_cast<int>(unscaled(header.textSize)));
+    mindMapData->setCornerRadius(static_cast<int>(unscaled(header.cornerRadius)));
+
+    const auto nodes = reader.records<NodeRecord>(le(header.nodeOffset), le(header.nodeCount));
+    for (quint32 i = 0; i < le(header.nodeCount); i++) {
+        const auto & record = nodes[i];
+        // Init a new node. QGraphicsScene will take the ownership eventually.
+        auto node = std::make_unique<Node>();
+        node->setIndex(le(record.index));
+        node->setLocation(QPointF(unscaled(record.x), unscaled(record.y)));
+        node->setTextAndSize(reader.string(record.text), QSizeF(unscaled(record.w), unscaled(record.h)));
+        node->setColor(color(record.color));
+        node->setTextColor(color(record.textColor));
+        node->setImageRef(le(record.imageRef));
+        mindMapData->graph().addNode(std::move(node));
+    }
+
+    const auto edges = reader.records<EdgeRecord>(le(header.edgeOffset), le(header.edgeCount));
+    for (quint32 i = 0; i < le(header.edgeCount); i++) {
+        const auto & record = edges[i];
+        // Initialize a new edge. QGraphicsScene will take the ownership eventually.
+        auto edge = std::make_unique<Edge>(*mindMapData->graph().getNode(le(record.index0)), *mindMapData->graph().getNode(le(record.index1)));
+        edge->setArrowMode(static_cast<Edge::ArrowMode>(le(record.arrowMode)));
+        edge->setReversed(le(record.reversed));
+        edge->setText(reader.string(record.text));
+        mindMapData->graph().addEdge(std::move(edge));
+    }
+
+    const auto images = reader.records<ImageRecord>(le(header.imageOffset), le(header.imageCount));
+    std::vector<std::future<Image>> extractedImages;
+    try {
+        for (quint32 i = 0; i < le(header.imageCount); i++) {
+            extractedImages.push_back(extractImage(reader.blob(images[i]), le(images[i].id), reader.string(images[i].path).toStdString()));
+        }
+    } catch (...) {
+        waitAll(extractedImages);
+        throw;
+    }
+    for (auto && extractedImage : extractedImages) {
+        mindMapData->imageManager().setImage(extractedImage.get());
+    }
+
+    double aspectRatio = bitsToDouble(header.aspectRatio);
+    aspectRatio = std::min(aspectRatio, Constants::LayoutOptimizer::MAX_ASPECT_RATIO);
+    aspectRatio = std::max(aspectRatio, Constants::LayoutOptimizer::MIN_ASPECT_RATIO);
+    mindMapData->setAspectRatio(aspectRatio);
+
+    double minEdgeLength = bitsToDouble(header.minEdgeLength);
+    minEdgeLength = std::min(minEdgeLength, Constants::LayoutOptimizer::MAX_EDGE_LENGTH);
+    minEdgeLength = std::max(minEdgeLength, Constants::LayoutOptimizer::MIN_EDGE_LENGTH);
+    mindMapData->setMinEdgeLength(minEdgeLength);
+
+    if (reader.hasView() && le(header.viewW) > 0 && le(header.viewH) > 0) {
+        mindMapData->setViewRect({ unscaled(header.viewX), unscaled(header.viewY), unscaled(header.viewW), unscaled(header.viewH) });
+    }
+
+    ImageImportOptions imageImportOptions;
+    imageImportOptions.maxSize = static_cast<int>(std::min(le(header.imageMaxSize), static_cast<quint32>(Constants::ImageImport::MAX_MAX_SIZE)));
+    imageImportOptions.format = reader.string(header.imageFormat);
+    imageImportOptions.quality = std::min(std::max(static_cast<int>(le(header.imageQuality)), -1), Constants::ImageImport::MAX_QUALITY);
+    mindMapData->setImageImportOptions(imageImportOptions);
+
+    return mindMapData;
+}
+
+std::unique_ptr<MindMapData> fromBinary(const QByteArray & binary)
+{
+    return fromBinary(binary.constData(), binary.size());
+}
+
+std::unique_ptr<MindMapData> readFromFile(QString filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw FileException(QObject::tr("Cannot open file: '") + filePath + "'");
+    }
+
+    std::unique_ptr<MindMapData> mindMapData;
+    const auto size = file.size();
+    if (const auto data = file.map(0, size)) {
+        try {
+            mindMapData = fromBinary(reinterpret_cast<const char *>(data), size);
+        } catch (const std::runtime_error & e) {
+            juzzlin::L().error() << e.what();
+            throw FileException(QObject::tr("Corrupted file: '") + filePath + "'");
+        }
+        file.unmap(data);
+    } else {
+        // Records are accessed in place, so the copy has to stay alive until the mind map is built
+        const auto binary = file.readAll();
+        try {
+            mindMapData = fromBinary(binary);
+        } catch (const std::runtime_error & e) {
+            juzzlin::L().error() << e.what();
+            throw FileException(QObject::tr("Corrupted file: '") + filePath + "'");
+        }
+    }
+
+    return mindMapData;
+}
+
+bool writeToFile(const MindMapState & state, QString filePath)
+{
+    QSaveFile file(filePath);
+    if (file.open(QIODevice::WriteOnly)) {
+        toBinary(state, file);
+        return file.commit();
+    }
+
+    return false;
+}
+
+bool writeToFile(const MindMapData & mindMapData, QString filePath)
+{
+    return writeToFile(MindMapState::captureForSaving(mindMapData), filePath);
+}
+
+} // namespace AlzbSerializer
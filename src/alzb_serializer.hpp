@@ -0,0 +1,58 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ALZB_SERIALIZER_HPP
+#define ALZB_SERIALIZER_HPP
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+
+#include <memory>
+
+class MindMapData;
+struct MindMapState;
+
+//! Binary counterpart of AlzSerializer. The container is a fixed header followed by
+//! little-endian node, edge and image record arrays, a UTF-8 string table and raw image blobs.
+//! The record arrays are accessed in place so that a memory-mapped file needs almost no parsing.
+namespace AlzbSerializer {
+
+static constexpr int MAGIC_SIZE = 4;
+
+//! \return true if the given leading bytes identify a binary mind map.
+bool isBinary(const QByteArray & header);
+
+//! Throws std::runtime_error if the data is not a valid container.
+std::unique_ptr<MindMapData> fromBinary(const char * data, qint64 size);
+
+std::unique_ptr<MindMapData> fromBinary(const QByteArray & binary);
+
+//! Only plain data is accessed, so the state can be written on a worker thread.
+//! Throws std::runtime_error if an embedded image cannot be read.
+void toBinary(const MindMapState & state, QIODevice & device);
+
+QByteArray toBinary(const MindMapData & mindMapData);
+
+//! Memory-maps the file and builds the mind map from it. Throws FileException on failure.
+std::unique_ptr<MindMapData> readFromFile(QString filePath);
+
+bool writeToFile(const MindMapState & state, QString filePath);
+
+bool writeToFile(const MindMapData & mindMapData, QString filePath);
+
+} // namespace AlzbSerializer
+
+#endif // ALZB_SERIALIZER_HPP
@@ -14,10 +14,12 @@
 // along with Heimer. If not, see <http://www.gnu.org/licenses/>.
 
 #include "application.hpp"
+#include "autosave_manager.hpp"
 #include "constants.hpp"
 #include "editor_data.hpp"
 #include "editor_scene.hpp"
 #include "editor_view.hpp"
+#include "image_importer.hpp"
 #include "image_manager.hpp"
 #include "layout_optimization_dialog.hpp"
 #include "layout_optimizer.hpp"
@@ -138,9 +140,11 @@ Application::Application(int & argc, char ** argv)
     m_mainWindow = std::make_unique<MainWindow>();
     m_mediator = std::make_unique<Mediator>(*m_mainWindow);
     m_editorData = std::make_unique<EditorData>();
+    m_autosaveManager = std::make_unique<AutosaveManager>(*m_editorData);
     m_editorView = new EditorView(*m_mediator);
     m_pngExportDialog = std::make_unique<PngExportDialog>(*m_mainWindow);
     m_svgExportDialog = std::make_unique<SvgExportDialog>(*m_mainWindow);
+    m_imageImporter = std::make_unique<ImageImporter>();
 
     m_mainWindow->setMediator(m_mediator);
     m_stateMachine->setMediator(m_mediator);
@@ -161,6 +165,16 @@ Application::Application(int & argc, char ** argv)
         m_mainWindow->enableSave(isModified || m_mediator->canBeSaved());
     });
 
+    connect(m_editorData.get(), &EditorData::saveFinished, this, &Application::finishSave);
+
+    // Images imported for the previous mind map don't belong to the new one
+    connect(m_editorData.get(), &EditorData::mindMapDataChanged, m_imageImporter.get(), &ImageImporter::discardPending);
+
+    connect(m_imageImporter.get(), &ImageImporter::imported, this, &Application::addImportedImage);
+    connect(m_imageImporter.get(), &ImageImporter::importFailed, [this](QString fileName) {
+        QMessageBox::critical(m_mainWindow.get(), tr("Load image"), tr("Failed to load image '") + fileName + "'");
+    });
+
     connect(m_pngExportDialog.get(), &PngExportDialog::pngExportRequested, m_mediator.get(), &Mediator::exportToPng);
     connect(m_svgExportDialog.get(), &SvgExportDialog::svgExportRequested, m_mediator.get(), &Mediator::exportToSvg);
 
@@ -181,14 +195,12 @@ Application::Application(int & argc, char ** argv)
 
     m_mainWindow->appear();
 
-    if (!m_mindMapFile.isEmpty()) {
-        QTimer::singleShot(0, this, &Application::openArgMindMap);
-    }
+    QTimer::singleShot(0, this, &Application::checkRecovery);
 }
 
 QString Application::getFileDialogFileText() const
 {
-    return tr("Heimer Files") + " (*" + Constants::Application::FILE_EXTENSION + ")";
+    return tr("Heimer Files") + " (*" + Constants::Application::FILE_EXTENSION + " *" + Constants::Application::BINARY_FILE_EXTENSION + " *" + Constants::Application::COMPRESSED_FILE_EXTENSION + ")";
 }
 
 int Application::run()
@@ -204,6 +216,7 @@ void Application::runState(StateMachine::State state)
         m_mainWindow->close();
         break;
     case StateMachine::State::Exit:
+        m_autosaveManager->clear();
         m_mainWindow->saveWindowSize();
         QApplication::exit(EXIT_SUCCESS);
         break;
@@ -263,6 +276,26 @@ void Application::runState(StateMachine::State state)
     }
 }
 
+void Application::checkRecovery()
+{
+    if (m_autosaveManager->hasRecoveryFile() && showRecoveryDialog() == QMessageBox::Yes) {
+        L().debug() << "Recovering '" << m_autosaveManager->recoveryFilePath().toStdString() << "'";
+        if (m_mediator->recoverMindMap(m_autosaveManager->recoveryFilePath(), m_autosaveManager->recoveryFileName())) {
+            m_mainWindow->disableUndoAndRedo();
+            emit actionTriggered(StateMachine::Action::MindMapOpened);
+            m_autosaveManager->start();
+            return;
+        }
+    }
+
+    m_autosaveManager->clear();
+    m_autosaveManager->start();
+
+    if (!m_mindMapFile.isEmpty()) {
+        openArgMindMap();
+    }
+}
+
 void Application::openArgMindMap()
 {
     doOpenMindMap(m_mindMapFile);
@@ -299,16 +332,8 @@ void Application::saveMindMap()
 {
     L().debug() << "Save..";
 
-    if (!m_mediator->saveMindMap()) {
-        const auto msg = QString(tr("Failed to save file."));
-        L().error() << msg.toStdString();
-        showMessageBox(msg);
-        emit actionTriggered(StateMachine::Action::MindMapSaveFailed);
-        return;
-    }
-
-    m_mainWindow->enableSave(false);
-    emit actionTriggered(StateMachine::Action::MindMapSaved);
+    m_isSavingAs = false;
+    m_mediator->saveMindMap();
 }
 
 void Application::saveMindMapAs()
@@ -326,21 +351,41 @@ void Application::saveMindMapAs()
         return;
     }
 
-    if (!fileName.endsWith(Constants::Application::FILE_EXTENSION)) {
+    if (!fileName.endsWith(Constants::Application::FILE_EXTENSION) && !fileName.endsWith(Constants::Application::BINARY_FILE_EXTENSION)
+        && !fileName.endsWith(Constants::Application::COMPRESSED_FILE_EXTENSION)) {
         fileName += Constants::Application::FILE_EXTENSION;
     }
 
-    if (m_mediator->saveMindMapAs(fileName)) {
-        const auto msg = QString(tr("File '")) + fileName + tr("' saved.");
-        L().debug() << msg.toStdString();
-        m_mainWindow->enableSave(false);
-        Settings::saveRecentPath(fileName);
-        emit actionTriggered(StateMachine::Action::MindMapSavedAs);
+    m_isSavingAs = true;
+    m_mediator->saveMindMapAs(fileName);
+}
+
+void Application::finishSave(bool success, QString fileName)
+{
+    if (m_isSavingAs) {
+        m_isSavingAs = false;
+        if (success) {
+            const auto msg = QString(tr("File '")) + fileName + tr("' saved.");
+            L().debug() << msg.toStdString();
+            m_mainWindow->enableSave(m_mediator->isModified());
+            Settings::saveRecentPath(fileName);
+            emit actionTriggered(StateMachine::Action::MindMapSavedAs);
+        } else {
+            const auto msg = QString(tr("Failed to save file as '") + fileName + "'.");
+            L().error() << msg.toStdString();
+            showMessageBox(msg);
+            emit actionTriggered(StateMachine::Action::MindMapSaveAsFailed);
+        }
     } else {
-        const auto msg = QString(tr("Failed to save file as '") + fileName + "'.");
-        L().error() << msg.toStdString();
-        showMessageBox(msg);
-        emit actionTriggered(StateMachine::Action::MindMapSaveAsFailed);
+        if (success) {
+            m_mainWindow->enableSave(m_mediator->isModified());
+            emit actionTriggered(StateMachine::Action::MindMapSaved);
+        } else {
+            const auto msg = QString(tr("Failed to save file."));
+            L().error() << msg.toStdString();
+            showMessageBox(msg);
+            emit actionTriggered(StateMachine::Action::MindMapSaveFailed);
+        }
     }
 }
 
@@ -378,19 +423,27 @@ void Application::showImageFileDialog()
     const auto fileName = QFileDialog::getOpenFileName(
       m_mainWindow.get(), tr("Open an image"), path, tr("Image Files") + " " + extensions);
 
-    QImage qImage;
-    if (qImage.load(fileName)) {
-        const Image image { qImage, fileName.toStdString() };
-        const auto id = m_editorData->mindMapData()->imageManager().addImage(image);
-        if (m_actionNode) {
-            juzzlin::L().info() << "Setting image id=" << id << " to node " << m_actionNode->index();
+    if (!fileName.isEmpty()) {
+        // The node may be gone by the time the import finishes, so it is looked up again by index
+        const auto nodeIndex = m_actionNode ? m_actionNode->index() : -1;
+        m_actionNode = nullptr;
+        m_imageImporter->import(fileName, m_editorData->mindMapData()->imageImportOptions(), nodeIndex);
+    }
+}
+
+void Application::addImportedImage(const Image & image, int nodeIndex)
+{
+    const auto id = m_editorData->mindMapData()->imageManager().addImage(image);
+    Settings::saveRecentImagePath(image.path().c_str());
+    if (nodeIndex >= 0) {
+        try {
+            const auto node = m_editorData->mindMapData()->graph().getNode(nodeIndex);
+            juzzlin::L().info() << "Setting image id=" << id << " to node " << node->index();
             m_mediator->saveUndoPoint();
-            m_actionNode->setImageRef(id);
-            m_actionNode = nullptr;
-            Settings::saveRecentImagePath(fileName);
+            node->setImageRef(id);
+        } catch (const std::runtime_error & e) {
+            juzzlin::L().warning() << "Cannot set imported image: " << e.what();
         }
-    } else if (fileName != "") {
-        QMessageBox::critical(m_mainWindow.get(), tr("Load image"), tr("Failed to load image '") + fileName + "'");
     }
 }
 
@@ -441,4 +494,14 @@ int Application::showNotSavedDialog()
     return msgBox.exec();
 }
 
+int Application::showRecoveryDialog()
+{
+    QMessageBox msgBox(m_mainWindow.get());
+    msgBox.setText(tr("Heimer was not closed properly."));
+    msgBox.setInformativeText(tr("Do you want to restore the unsaved changes?"));
+    msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+    msgBox.setDefaultButton(QMessageBox::Yes);
+    return msgBox.exec();
+}
+
 Application::~Application() = default;
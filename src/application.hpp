@@ -25,8 +25,11 @@
 
 #include <memory>
 
+class AutosaveManager;
 class EditorData;
 class EditorView;
+class Image;
+class ImageImporter;
 class ImageManager;
 class MainWindow;
 class Mediator;
@@ -56,6 +59,8 @@ signals:
     void backgroundColorChanged(QColor color);
 
 private:
+    void checkRecovery();
+
     void doOpenMindMap(QString fileName);
 
     QString getFileDialogFileText() const;
@@ -68,6 +73,8 @@ private:
 
     void saveMindMapAs();
 
+    void finishSave(bool success, QString fileName);
+
     void showBackgroundColorDialog();
 
     void showEdgeColorDialog();
@@ -76,6 +83,8 @@ private:
 
     void showImageFileDialog();
 
+    void addImportedImage(const Image & image, int nodeIndex);
+
     void showLayoutOptimizationDialog();
 
     void showPngExportDialog();
@@ -86,6 +95,8 @@ private:
 
     int showNotSavedDialog();
 
+    int showRecoveryDialog();
+
     void parseArgs(int argc, char ** argv);
 
     QApplication m_app;
@@ -106,10 +117,16 @@ private:
 
     std::shared_ptr<EditorData> m_editorData;
 
+    std::unique_ptr<AutosaveManager> m_autosaveManager;
+
     EditorView * m_editorView = nullptr;
 
     Node * m_actionNode = nullptr;
 
+    bool m_isSavingAs = false;
+
+    std::unique_ptr<ImageImporter> m_imageImporter;
+
     std::unique_ptr<PngExportDialog> m_pngExportDialog;
 
     std::unique_ptr<SvgExportDialog> m_svgExportDialog;
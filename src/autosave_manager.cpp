@@ -0,0 +1,199 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "autosave_manager.hpp"
+
+#include "alzb_serializer.hpp"
+#include "constants.hpp"
+#include "editor_data.hpp"
+#include "mind_map_data.hpp"
+#include "mind_map_state.hpp"
+#include "settings.hpp"
+#include "simple_logger.hpp"
+#include "worker_pool.hpp"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <stdexcept>
+
+AutosaveManager::AutosaveManager(EditorData & editorData)
+  : m_editorData(editorData)
+{
+    connect(&m_timer, &QTimer::timeout, this, &AutosaveManager::autosave);
+
+    lockRecoveryFile();
+}
+
+AutosaveManager::~AutosaveManager()
+{
+    if (m_result.valid()) {
+        m_result.wait();
+    }
+}
+
+// The first instance uses the plain file name and the others get numbered ones
+static QString recoveryFilePathForSlot(int slot)
+{
+    const QFileInfo fileInfo(Constants::Autosave::FILE_NAME);
+    const auto fileName = slot ? fileInfo.completeBaseName() + "-" + QString::number(slot) + "." + fileInfo.suffix() : fileInfo.fileName();
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/" + fileName;
+}
+
+void AutosaveManager::lockRecoveryFile()
+{
+    const auto dirPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dirPath);
+
+    // Numbered files may be left behind by any crashed instance, so find the highest number in use
+    const auto baseName = QFileInfo(Constants::Autosave::FILE_NAME).completeBaseName();
+    int slotCount = 1;
+    for (auto && fileName : QDir(dirPath).entryList({ baseName + "-*" }, QDir::Files)) {
+        slotCount = std::max(slotCount, fileName.mid(baseName.size() + 1).section('.', 0, 0).toInt() + 1);
+    }
+
+    // Prefer a recovery file of a crashed instance over an unused one
+    for (int slot = 0; !m_lockFile || (slot < slotCount && !hasRecoveryFile()); slot++) {
+        auto lockFile = std::make_unique<QLockFile>(recoveryFilePathForSlot(slot) + ".lock");
+        // The lock is held for the whole session, so it's stale only if the process is gone
+        lockFile->setStaleLockTime(0);
+        if (lockFile->tryLock()) {
+            if (!m_lockFile || QFile::exists(recoveryFilePathForSlot(slot))) {
+                m_lockFile = std::move(lockFile);
+                m_slot = slot;
+            }
+        } else if (lockFile->error() != QLockFile::LockFailedError) {
+            juzzlin::L().error() << "Cannot lock recovery file '" << recoveryFilePathForSlot(slot).toStdString() << "'";
+            break;
+        }
+    }
+
+    if (m_lockFile) {
+        juzzlin::L().debug() << "Locked recovery file '" << recoveryFilePath().toStdString() << "'";
+    }
+}
+
+QString AutosaveManager::recoveryFilePath() const
+{
+    return recoveryFilePathForSlot(m_slot);
+}
+
+bool AutosaveManager::hasRecoveryFile() const
+{
+    return m_lockFile && QFile::exists(recoveryFilePath());
+}
+
+QString AutosaveManager::recoveryFileName() const
+{
+    return Settings::loadRecoveryFileName(m_slot);
+}
+
+void AutosaveManager::clear()
+{
+    finishAutosave();
+
+    // The file may belong to another instance
+    if (!m_lockFile) {
+        return;
+    }
+
+    if (QFile::remove(recoveryFilePath())) {
+        juzzlin::L().debug() << "Removed recovery file";
+    }
+
+    Settings::saveRecoveryFileName(m_slot, "");
+    m_savedRevision = 0;
+}
+
+void AutosaveManager::start()
+{
+    // A saved or freshly loaded mind map doesn't need to be recovered
+    connect(&m_editorData, &EditorData::isModifiedChanged, this, [this](bool isModified) {
+        if (!isModified) {
+            clear();
+        }
+    });
+
+    const auto intervalSec = Settings::loadAutosaveIntervalSec();
+    if (!m_lockFile) {
+        juzzlin::L().warning() << "Autosave disabled, no recovery file";
+    } else if (intervalSec > 0) {
+        juzzlin::L().debug() << "Autosaving every " << intervalSec << " s";
+        m_timer.start(intervalSec * 1000);
+    } else {
+        juzzlin::L().debug() << "Autosave disabled";
+    }
+}
+
+void AutosaveManager::autosave()
+{
+    if (m_result.valid()) {
+        juzzlin::L().debug() << "Autosave still in progress..";
+        return;
+    }
+
+    const auto revision = m_editorData.revision();
+    if (!m_editorData.mindMapData() || !m_editorData.isModified() || revision == m_savedRevision) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    m_state = std::make_unique<MindMapState>(MindMapState::captureForSaving(*m_editorData.mindMapData()));
+    m_fileName = m_editorData.fileName();
+    m_revision = revision;
+    juzzlin::L().debug() << "Autosave captured the mind map in " << timer.elapsed() << " ms";
+
+    // Only plain data is captured on this thread and the worker never touches the graphics items
+    const auto state = m_state.get();
+    const auto filePath = recoveryFilePath();
+    m_result = WorkerPool::run([this, state, filePath] {
+        QElapsedTimer timer;
+        timer.start();
+        Result result;
+        try {
+            QDir().mkpath(QFileInfo(filePath).path());
+            result.saved = AlzbSerializer::writeToFile(*state, filePath);
+        } catch (const std::exception & e) {
+            juzzlin::L().error() << e.what();
+        }
+        result.elapsedMs = timer.elapsed();
+        QMetaObject::invokeMethod(this, "finishAutosave", Qt::QueuedConnection);
+        return result;
+    });
+}
+
+void AutosaveManager::finishAutosave()
+{
+    // Called both when the worker is done and to wait for an autosave in progress
+    if (!m_result.valid()) {
+        return;
+    }
+
+    const auto result = m_result.get();
+    m_state.reset();
+    if (result.saved) {
+        m_savedRevision = m_revision;
+        Settings::saveRecoveryFileName(m_slot, m_fileName);
+        juzzlin::L().debug() << "Autosaved " << QFileInfo(recoveryFilePath()).size() << " bytes in " << result.elapsedMs << " ms";
+    } else {
+        juzzlin::L().warning() << "Autosave to '" << recoveryFilePath().toStdString() << "' failed";
+    }
+}
@@ -0,0 +1,95 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef AUTOSAVE_MANAGER_HPP
+#define AUTOSAVE_MANAGER_HPP
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include <future>
+#include <memory>
+
+class EditorData;
+class QLockFile;
+struct MindMapState;
+
+//! Periodically writes a copy of a modified mind map to a recovery file in the application
+//! data location. Only a plain-data MindMapState is captured on the GUI thread; it's written
+//! in the binary format on the worker pool. The recovery file is removed when the mind map is saved or
+//! the application exits cleanly, so a remaining file means that the last session crashed.
+//! Each running instance locks a recovery file of its own for the whole session, so a remaining
+//! file can be taken over only when its lock is stale.
+class AutosaveManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AutosaveManager(EditorData & editorData);
+
+    ~AutosaveManager() override;
+
+    QString recoveryFilePath() const;
+
+    //! \return true if the previous session with the same recovery file crashed.
+    bool hasRecoveryFile() const;
+
+    //! Name of the file the recovered mind map belongs to, empty if it was never saved.
+    QString recoveryFileName() const;
+
+    //! Removes the recovery file, waiting for an autosave in progress.
+    void clear();
+
+    //! Starts autosaving with the interval from settings. An interval of zero disables autosave.
+    void start();
+
+private slots:
+
+    void autosave();
+
+    void finishAutosave();
+
+private:
+    struct Result
+    {
+        bool saved = false;
+
+        qint64 elapsedMs = 0;
+    };
+
+    //! Locks a recovery file not locked by another instance, preferring one left behind by a crash.
+    void lockRecoveryFile();
+
+    EditorData & m_editorData;
+
+    std::unique_ptr<QLockFile> m_lockFile;
+
+    int m_slot = 0;
+
+    QTimer m_timer;
+
+    std::unique_ptr<MindMapState> m_state;
+
+    QString m_fileName;
+
+    std::future<Result> m_result;
+
+    unsigned int m_revision = 0;
+
+    unsigned int m_savedRevision = 0;
+};
+
+#endif // AUTOSAVE_MANAGER_HPP
@@ -0,0 +1,124 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "compressing_device.hpp"
+
+#include "constants.hpp"
+#include "worker_pool.hpp"
+
+#include <QtEndian>
+
+#include <algorithm>
+
+CompressingDevice::CompressingDevice(QIODevice & device)
+  : m_device(device)
+{
+}
+
+CompressingDevice::~CompressingDevice()
+{
+    close();
+}
+
+bool CompressingDevice::open(OpenMode mode)
+{
+    if ((mode & ReadOnly) || !(mode & WriteOnly)) {
+        setErrorString(tr("Compressing device is write-only"));
+        return false;
+    }
+
+    m_hasError = false;
+    writeToDevice(QByteArray(Constants::Compression::MAGIC, Constants::Compression::MAGIC_SIZE));
+    return !m_hasError && QIODevice::open(mode);
+}
+
+void CompressingDevice::close()
+{
+    if (!isOpen()) {
+        return;
+    }
+
+    if (!m_chunk.isEmpty()) {
+        compressChunk();
+    }
+
+    writeFrames(0);
+    writeToDevice(QByteArray(sizeof(quint32), '\0'));
+    QIODevice::close();
+}
+
+bool CompressingDevice::isSequential() const
+{
+    return true;
+}
+
+bool CompressingDevice::hasError() const
+{
+    return m_hasError;
+}
+
+qint64 CompressingDevice::readData(char *, qint64)
+{
+    return -1;
+}
+
+qint64 CompressingDevice::writeData(const char * data, qint64 size)
+{
+    if (m_hasError) {
+        return -1;
+    }
+
+    qint64 written = 0;
+    while (written < size) {
+        const auto count = std::min<qint64>(size - written, Constants::Compression::CHUNK_SIZE - m_chunk.size());
+        m_chunk.append(data + written, static_cast<int>(count));
+        written += count;
+        if (m_chunk.size() >= Constants::Compression::CHUNK_SIZE) {
+            compressChunk();
+            writeFrames(Constants::Compression::MAX_PENDING_CHUNKS);
+        }
+    }
+
+    return m_hasError ? -1 : written;
+}
+
+void CompressingDevice::compressChunk()
+{
+    const auto chunk = m_chunk;
+    m_pending.push_back(WorkerPool::run([chunk] {
+        return qCompress(chunk, Constants::Compression::LEVEL);
+    }));
+    m_chunk.clear();
+}
+
+// Writes finished chunks in order until no more than maxPending are left in flight
+void CompressingDevice::writeFrames(size_t maxPending)
+{
+    while (m_pending.size() > maxPending) {
+        const auto frame = m_pending.front().get();
+        m_pending.pop_front();
+        QByteArray size(sizeof(quint32), '\0');
+        qToLittleEndian<quint32>(static_cast<quint32>(frame.size()), reinterpret_cast<uchar *>(size.data()));
+        writeToDevice(size + frame);
+    }
+}
+
+void CompressingDevice::writeToDevice(const QByteArray & data)
+{
+    if (!m_hasError && m_device.write(data) != data.size()) {
+        setErrorString(m_device.errorString());
+        m_hasError = true;
+    }
+}
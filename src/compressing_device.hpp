@@ -0,0 +1,67 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef COMPRESSING_DEVICE_HPP
+#define COMPRESSING_DEVICE_HPP
+
+#include <QByteArray>
+#include <QIODevice>
+
+#include <deque>
+#include <future>
+
+//! Write-only device that deflates everything written to it into the given device.
+//! The stream is a magic followed by independently compressed chunks, each prefixed
+//! by its little-endian size, and a zero size as the end marker. Chunks are compressed
+//! on the worker pool while the caller keeps producing data.
+class CompressingDevice : public QIODevice
+{
+public:
+    //! The target device must be open and outlive this device.
+    explicit CompressingDevice(QIODevice & device);
+
+    ~CompressingDevice() override;
+
+    bool open(OpenMode mode) override;
+
+    //! Writes the remaining chunks and the end marker. Check hasError() afterwards.
+    void close() override;
+
+    bool isSequential() const override;
+
+    bool hasError() const;
+
+protected:
+    qint64 readData(char * data, qint64 maxSize) override;
+
+    qint64 writeData(const char * data, qint64 size) override;
+
+private:
+    void compressChunk();
+
+    void writeFrames(size_t maxPending);
+
+    void writeToDevice(const QByteArray & data);
+
+    QIODevice & m_device;
+
+    QByteArray m_chunk;
+
+    std::deque<std::future<QByteArray>> m_pending;
+
+    bool m_hasError = false;
+};
+
+#endif // COMPRESSING_DEVICE_HPP
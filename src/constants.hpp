@@ -34,8 +34,25 @@ static constexpr auto APPLICATION_VERSION = VERSION;
 
 static constexpr auto COPYRIGHT = "Copyright (c) 2018-2020 Jussi Lind";
 
+static constexpr auto BINARY_FILE_EXTENSION = ".alzb";
+
+static constexpr auto COMPRESSED_FILE_EXTENSION = ".alzz";
+
 static constexpr auto FILE_EXTENSION = ".alz";
 
+static constexpr auto JOURNAL_FILE_EXTENSION = ".journal";
+
+//! The journal is folded into the base file when it grows over this many percents of the base file,
+//! but not before it reaches JOURNAL_MIN_FOLD_SIZE bytes
+static const qint64 JOURNAL_FOLD_PERCENT = 25;
+
+static const qint64 JOURNAL_MIN_FOLD_SIZE = 64 * 1024;
+
+//! Files at least this large are parsed in parallel chunks of at least PARALLEL_LOAD_CHUNK_SIZE bytes
+static const qint64 PARALLEL_LOAD_MIN_FILE_SIZE = 4 * 1024 * 1024;
+
+static const int PARALLEL_LOAD_CHUNK_SIZE = 256 * 1024;
+
 static constexpr auto QSETTINGS_COMPANY_NAME = "Heimer";
 
 static constexpr auto WEB_SITE_URL = "http://juzzlin.github.io/Heimer";
@@ -48,6 +65,29 @@ static constexpr auto TRANSLATIONS_RESOURCE_BASE = ":/translations/heimer_";
 
 } // namespace Application
 
+namespace Autosave {
+
+static const int DEFAULT_INTERVAL_SEC = 60;
+
+static constexpr auto FILE_NAME = "recovery.alzb";
+
+} // namespace Autosave
+
+namespace Compression {
+
+static constexpr auto MAGIC = "ALZZ";
+
+static const int MAGIC_SIZE = 4;
+
+//! Chunks are compressed independently so that they can be processed in parallel
+static const int CHUNK_SIZE = 1024 * 1024;
+
+static const int MAX_PENDING_CHUNKS = 8;
+
+static const int LEVEL = 6;
+
+} // namespace Compression
+
 namespace Edge {
 
 static const double ARROW_LENGTH = 10;
@@ -108,6 +148,24 @@ static const int MAX_SIZE = 500;
 
 } // namespace Grid
 
+namespace ImageCache {
+
+static const int DEFAULT_SIZE_MB = 256;
+
+} // namespace ImageCache
+
+namespace ImageImport {
+
+static const int DEFAULT_MAX_SIZE = 2048;
+
+static const int MAX_MAX_SIZE = 16384;
+
+static const int DEFAULT_QUALITY = -1;
+
+static const int MAX_QUALITY = 100;
+
+} // namespace ImageImport
+
 namespace MindMap {
 
 static const QColor DEFAULT_BACKGROUND_COLOR { 0xba, 0xbd, 0xb6 };
@@ -192,12 +250,38 @@ static const int MAX_SIZE = 24;
 
 } // namespace Text
 
+namespace Undo {
+
+//! Undo history is trimmed from the oldest end to stay within this many bytes
+static const size_t MEMORY_BUDGET = 64 * 1024 * 1024;
+
+//! The latest undo steps up to this many bytes are kept uncompressed
+static const size_t HOT_BUDGET = 4 * 1024 * 1024;
+
+static const int COMPRESSION_LEVEL = 1;
+
+static constexpr auto LOG_FILE_EXTENSION = ".undo";
+
+//! The undo log is rewritten when it grows over this many times the size of the history still in use,
+//! but not before it reaches LOG_MIN_COMPACT_SIZE bytes
+static const qint64 LOG_COMPACT_FACTOR = 4;
+
+static const qint64 LOG_MIN_COMPACT_SIZE = 1024 * 1024;
+
+} // namespace Undo
+
 namespace View {
 
 static const int CLICK_TOLERANCE = 5;
 
 static const double DRAG_NODE_OPACITY = 0.5;
 
+// Mind maps with at least this many nodes are shown viewport first when the saved view is known
+static const size_t PARTIAL_LOAD_MIN_NODES = 1000;
+
+// Number of items added to the scene per event loop iteration when populating it in the background
+static const size_t POPULATE_BATCH_SIZE = 500;
+
 static const int TOO_QUICK_ACTION_DELAY_MS = 500;
 
 static const int ZOOM_MAX = 200;
@@ -0,0 +1,167 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "decompressing_device.hpp"
+
+#include "constants.hpp"
+#include "simple_logger.hpp"
+#include "worker_pool.hpp"
+
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+// A chunk that doesn't compress grows slightly, see zlib's compressBound()
+static const quint32 MAX_FRAME_SIZE = Constants::Compression::CHUNK_SIZE + Constants::Compression::CHUNK_SIZE / 100 + 64;
+
+DecompressingDevice::DecompressingDevice(QIODevice & device)
+  : m_device(device)
+{
+}
+
+bool DecompressingDevice::isCompressed(const QByteArray & header)
+{
+    return header.size() >= Constants::Compression::MAGIC_SIZE && std::memcmp(header.constData(), Constants::Compression::MAGIC, Constants::Compression::MAGIC_SIZE) == 0;
+}
+
+bool DecompressingDevice::open(OpenMode mode)
+{
+    if ((mode & WriteOnly) || !(mode & ReadOnly)) {
+        setErrorString(tr("Decompressing device is read-only"));
+        return false;
+    }
+
+    if (!isCompressed(m_device.read(Constants::Compression::MAGIC_SIZE))) {
+        setErrorString(tr("Not a compressed stream"));
+        return false;
+    }
+
+    m_chunk.clear();
+    m_position = 0;
+    m_pending.clear();
+    m_pendingSize = 0;
+    m_endReached = false;
+    m_hasError = false;
+    readFrames();
+    return QIODevice::open(mode);
+}
+
+qint64 DecompressingDevice::bytesAvailable() const
+{
+    return m_chunk.size() - m_position + m_pendingSize + QIODevice::bytesAvailable();
+}
+
+bool DecompressingDevice::isSequential() const
+{
+    return true;
+}
+
+bool DecompressingDevice::hasError() const
+{
+    return m_hasError;
+}
+
+qint64 DecompressingDevice::readData(char * data, qint64 maxSize)
+{
+    qint64 total = 0;
+    while (total < maxSize) {
+        if (m_position >= m_chunk.size() && !nextChunk()) {
+            break;
+        }
+
+        const auto count = std::min<qint64>(maxSize - total, m_chunk.size() - m_position);
+        std::memcpy(data + total, m_chunk.constData() + m_position, static_cast<size_t>(count));
+        m_position += static_cast<int>(count);
+        total += count;
+    }
+
+    return total || !m_hasError ? total : -1;
+}
+
+qint64 DecompressingDevice::writeData(const char *, qint64)
+{
+    return -1;
+}
+
+// Keeps up to MAX_PENDING_CHUNKS chunks being decompressed ahead of the reader
+void DecompressingDevice::readFrames()
+{
+    while (!m_endReached && !m_hasError && m_pending.size() < static_cast<size_t>(Constants::Compression::MAX_PENDING_CHUNKS)) {
+        const auto header = m_device.read(sizeof(quint32));
+        if (header.size() != sizeof(quint32)) {
+            setError("Truncated compressed stream");
+            return;
+        }
+
+        const auto frameSize = qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(header.constData()));
+        if (!frameSize) {
+            m_endReached = true;
+            return;
+        }
+
+        if (frameSize < sizeof(quint32) || frameSize > MAX_FRAME_SIZE) {
+            setError("Invalid compressed chunk size");
+            return;
+        }
+
+        const auto frame = m_device.read(frameSize);
+        if (frame.size() != static_cast<int>(frameSize)) {
+            setError("Truncated compressed stream");
+            return;
+        }
+
+        // qCompress() stores the uncompressed size as a big-endian prefix
+        const auto size = qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(frame.constData()));
+        if (size > static_cast<quint32>(Constants::Compression::CHUNK_SIZE)) {
+            setError("Invalid compressed chunk");
+            return;
+        }
+
+        m_pending.push_back({ WorkerPool::run([frame] {
+                                 return qUncompress(frame);
+                             }),
+                              static_cast<int>(size) });
+        m_pendingSize += size;
+    }
+}
+
+bool DecompressingDevice::nextChunk()
+{
+    if (m_pending.empty()) {
+        return false;
+    }
+
+    auto pending = std::move(m_pending.front());
+    m_pending.pop_front();
+    m_pendingSize -= pending.size;
+    m_chunk = pending.data.get();
+    m_position = 0;
+    if (m_chunk.size() != pending.size) {
+        m_chunk.clear();
+        setError("Corrupted compressed chunk");
+        return false;
+    }
+
+    readFrames();
+    return true;
+}
+
+void DecompressingDevice::setError(QString error)
+{
+    juzzlin::L().error() << error.toStdString();
+    setErrorString(error);
+    m_hasError = true;
+}
@@ -0,0 +1,80 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef DECOMPRESSING_DEVICE_HPP
+#define DECOMPRESSING_DEVICE_HPP
+
+#include <QByteArray>
+#include <QIODevice>
+
+#include <deque>
+#include <future>
+
+//! Read-only device that inflates a stream written by CompressingDevice. The following
+//! chunks are read ahead and decompressed on the worker pool while the caller consumes
+//! the current one. Reading fails with an error if the stream is corrupted or truncated.
+class DecompressingDevice : public QIODevice
+{
+public:
+    //! The source device must be open and outlive this device.
+    explicit DecompressingDevice(QIODevice & device);
+
+    //! \return true if the given leading bytes identify a compressed stream.
+    static bool isCompressed(const QByteArray & header);
+
+    //! Fails if the source doesn't start with a compressed stream.
+    bool open(OpenMode mode) override;
+
+    qint64 bytesAvailable() const override;
+
+    bool isSequential() const override;
+
+    bool hasError() const;
+
+protected:
+    qint64 readData(char * data, qint64 maxSize) override;
+
+    qint64 writeData(const char * data, qint64 size) override;
+
+private:
+    void readFrames();
+
+    bool nextChunk();
+
+    void setError(QString error);
+
+    struct PendingChunk
+    {
+        std::future<QByteArray> data;
+
+        int size;
+    };
+
+    QIODevice & m_device;
+
+    QByteArray m_chunk;
+
+    int m_position = 0;
+
+    std::deque<PendingChunk> m_pending;
+
+    qint64 m_pendingSize = 0;
+
+    bool m_endReached = false;
+
+    bool m_hasError = false;
+};
+
+#endif // DECOMPRESSING_DEVICE_HPP
@@ -19,6 +19,7 @@
 #include "defaults.hpp"
 #include "edge_dot.hpp"
 #include "edge_text_edit.hpp"
+#include "edge_update_scheduler.hpp"
 #include "graphics_factory.hpp"
 #include "layers.hpp"
 #include "node.hpp"
@@ -154,14 +155,14 @@ void Edge::setWidth(double width)
 
     setPen(getPen());
     setArrowHeadPen(pen());
-    updateLine();
+    updateLineInScene();
 }
 
 void Edge::setArrowMode(ArrowMode arrowMode)
 {
     m_arrowMode = arrowMode;
     if (!TestMode::enabled()) {
-        updateLine();
+        updateLineInScene();
     } else {
         TestMode::logDisabledCode("Update line after arrow mode change");
     }
@@ -173,7 +174,7 @@ void Edge::setColor(const QColor & color)
 
     setPen(getPen());
     setArrowHeadPen(pen());
-    updateLine();
+    updateLineInScene();
 }
 
 void Edge::setText(const QString & text)
@@ -284,7 +285,7 @@ void Edge::updateDots()
 {
     if (m_enableAnimations) {
         // Trigger new animation if relative connection location has changed
-        const auto newRelativeSourcePos = line().p1() - sourceNode().pos();
+        const auto newRelativeSourcePos = line().p1() + pos() - sourceNode().pos();
         if (m_previousRelativeSourcePos != newRelativeSourcePos) {
             m_previousRelativeSourcePos = newRelativeSourcePos;
             m_sourceDotSizeAnimation->stop();
@@ -295,7 +296,7 @@ void Edge::updateDots()
         m_sourceDot->setPos(line().p1());
 
         // Trigger new animation if relative connection location has changed
-        const auto newRelativeTargetPos = line().p2() - targetNode().pos();
+        const auto newRelativeTargetPos = line().p2() + pos() - targetNode().pos();
         if (m_previousRelativeTargetPos != newRelativeTargetPos) {
             m_previousRelativeTargetPos = newRelativeTargetPos;
             m_targetDotSizeAnimation->stop();
@@ -334,6 +335,11 @@ Edge::ArrowMode Edge::arrowMode() const
     return m_arrowMode;
 }
 
+void Edge::translate(QPointF delta)
+{
+    moveBy(delta.x(), delta.y());
+}
+
 QString Edge::text() const
 {
     return m_text;
@@ -351,16 +357,27 @@ void Edge::updateLine()
     QVector2D direction2(targetNode().pos() - p2);
     direction2.normalize();
 
-    setLine(QLineF(
+    const QLineF sceneLine(
       p1 + (nearestPoints.first.isCorner ? Constants::Edge::CORNER_RADIUS_SCALE * (direction1 * sourceNode().cornerRadius()).toPointF() : QPointF { 0, 0 }),
       p2 + (nearestPoints.second.isCorner ? Constants::Edge::CORNER_RADIUS_SCALE * (direction2 * targetNode().cornerRadius()).toPointF() : QPointF { 0, 0 }) - //
-        (direction2 * static_cast<float>(m_width)).toPointF() * Constants::Edge::WIDTH_SCALE));
+        (direction2 * static_cast<float>(m_width)).toPointF() * Constants::Edge::WIDTH_SCALE);
+
+    // The edge may have been translated along with its nodes, see translate()
+    setLine(sceneLine.translated(-pos()));
 
     updateDots();
     updateLabel();
     updateArrowhead();
 }
 
+// The line of an edge that is not in the scene yet is calculated once when it's added
+void Edge::updateLineInScene()
+{
+    if (scene()) {
+        updateLine();
+    }
+}
+
 Edge::~Edge()
 {
     if (!TestMode::enabled()) {
@@ -373,6 +390,7 @@ Edge::~Edge()
 
         sourceNode().removeGraphicsEdge(*this);
         targetNode().removeGraphicsEdge(*this);
+        EdgeUpdateScheduler::instance().unschedule(*this);
     } else {
         TestMode::logDisabledCode("Edge destructor");
     }
@@ -65,6 +65,9 @@ public:
 
     bool reversed() const;
 
+    //! Moves the edge along with both of its nodes without recalculating it.
+    void translate(QPointF delta);
+
 public slots:
 
     void updateLine();
@@ -98,6 +101,8 @@ private:
 
     void updateArrowhead();
 
+    void updateLineInScene();
+
     void updateDots();
 
     void updateLabel();
@@ -0,0 +1,65 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "edge_update_scheduler.hpp"
+
+#include "edge.hpp"
+
+#include <QTimer>
+
+#include <vector>
+
+std::unique_ptr<EdgeUpdateScheduler> EdgeUpdateScheduler::m_instance;
+
+EdgeUpdateScheduler::EdgeUpdateScheduler()
+{
+}
+
+EdgeUpdateScheduler & EdgeUpdateScheduler::instance()
+{
+    if (!EdgeUpdateScheduler::m_instance) {
+        EdgeUpdateScheduler::m_instance = std::make_unique<EdgeUpdateScheduler>();
+    }
+    return *EdgeUpdateScheduler::m_instance;
+}
+
+void EdgeUpdateScheduler::schedule(Edge & edge)
+{
+    m_edges.insert(&edge);
+
+    if (!m_isFlushPending) {
+        m_isFlushPending = true;
+        QTimer::singleShot(0, [] {
+            EdgeUpdateScheduler::instance().flush();
+        });
+    }
+}
+
+void EdgeUpdateScheduler::unschedule(Edge & edge)
+{
+    m_edges.erase(&edge);
+}
+
+void EdgeUpdateScheduler::flush()
+{
+    m_isFlushPending = false;
+
+    // Take the edges first in case an update schedules more
+    std::vector<Edge *> edges(m_edges.begin(), m_edges.end());
+    m_edges.clear();
+    for (auto && edge : edges) {
+        edge->updateLine();
+    }
+}
@@ -0,0 +1,50 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef EDGE_UPDATE_SCHEDULER_HPP
+#define EDGE_UPDATE_SCHEDULER_HPP
+
+#include <memory>
+#include <unordered_set>
+
+class Edge;
+
+//! Collects the edges whose nodes have moved or changed and updates the line of each of them once
+//! on the next event loop iteration. Moving many nodes at once, e.g. when dragging a selection, then
+//! updates an edge shared by them only once per frame. Only to be used on the GUI thread.
+class EdgeUpdateScheduler
+{
+public:
+    EdgeUpdateScheduler();
+
+    static EdgeUpdateScheduler & instance();
+
+    void schedule(Edge & edge);
+
+    //! Called when the edge is deleted.
+    void unschedule(Edge & edge);
+
+    //! Updates the scheduled edges right away, e.g. before rendering the scene into an image.
+    void flush();
+
+private:
+    static std::unique_ptr<EdgeUpdateScheduler> m_instance;
+
+    std::unordered_set<Edge *> m_edges;
+
+    bool m_isFlushPending = false;
+};
+
+#endif // EDGE_UPDATE_SCHEDULER_HPP
@@ -16,11 +16,14 @@
 #include "editor_data.hpp"
 
 #include "alz_serializer.hpp"
+#include "alzb_serializer.hpp"
 #include "constants.hpp"
 #include "node.hpp"
 #include "recent_files_manager.hpp"
 #include "selection_group.hpp"
+#include "settings.hpp"
 #include "test_mode.hpp"
+#include "worker_pool.hpp"
 #include "xml_reader.hpp"
 #include "xml_writer.hpp"
 
@@ -28,8 +31,15 @@
 
 using juzzlin::L;
 
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <map>
 #include <memory>
+#include <stdexcept>
 
 using std::make_shared;
 
@@ -38,6 +48,9 @@ EditorData::EditorData()
 {
     m_undoTimer.setSingleShot(true);
     m_undoTimer.setInterval(Constants::View::TOO_QUICK_ACTION_DELAY_MS);
+
+    // Saves are written one at a time
+    m_savePool.setMaxThreadCount(1);
 }
 
 QColor EditorData::backgroundColor() const
@@ -56,23 +69,68 @@ QString EditorData::fileName() const
     return m_fileName;
 }
 
-void EditorData::loadMindMapData(QString fileName)
+static bool isBinaryFile(QString fileName)
+{
+    QFile file(fileName);
+    return file.open(QIODevice::ReadOnly) && AlzbSerializer::isBinary(file.peek(AlzbSerializer::MAGIC_SIZE));
+}
+
+void EditorData::readMindMapData(QString fileName)
 {
+    finishSave();
+
     clearImages();
     clearSelectionGroup();
 
     m_selectedEdge = nullptr;
 
     if (!TestMode::enabled()) {
-        setMindMapData(AlzSerializer::fromXml(XmlReader::readFromFile(fileName)));
+        if (isBinaryFile(fileName)) {
+            setMindMapData(AlzbSerializer::readFromFile(fileName));
+        } else if (QFileInfo(fileName).size() >= Constants::Application::PARALLEL_LOAD_MIN_FILE_SIZE) {
+            std::unique_ptr<MindMapData> data;
+            XmlReader::mapFile(fileName, [&data](const QByteArray & xml) {
+                data = AlzSerializer::fromXmlParallel(xml, Constants::Application::PARALLEL_LOAD_CHUNK_SIZE);
+            });
+            setMindMapData(std::move(data));
+        } else {
+            std::unique_ptr<MindMapData> data;
+            XmlReader::readFromFile(fileName, [&data](QXmlStreamReader & reader) {
+                data = AlzSerializer::fromXml(reader);
+            });
+            setMindMapData(std::move(data));
+        }
+        AlzJournal::replay(fileName, *m_mindMapData);
     } else {
         TestMode::logDisabledCode("setMindMapData");
     }
+}
+
+void EditorData::loadMindMapData(QString fileName)
+{
+    readMindMapData(fileName);
 
     m_fileName = fileName;
+    saveSnapshot();
     setIsModified(false);
     RecentFilesManager::instance().addRecentFile(fileName);
 
+    m_undoStack.clear();
+    if (!TestMode::enabled() && Settings::loadPersistUndoHistory()) {
+        m_undoStack.load(fileName, *m_mindMapData);
+    }
+    sendUndoAndRedoSignals();
+}
+
+void EditorData::recoverMindMapData(QString recoveryFileName, QString fileName)
+{
+    readMindMapData(recoveryFileName);
+
+    // The recovered changes are not in the original file
+    m_fileName = fileName;
+    m_savedSnapshot = {};
+    setIsModified(true);
+
     m_undoStack.clear();
 }
 
@@ -86,17 +144,18 @@ bool EditorData::isUndoable() const
     return m_undoStack.isUndoable();
 }
 
-void EditorData::undo()
+UndoCommand::Result EditorData::undo()
 {
+    UndoCommand::Result result;
     if (m_undoStack.isUndoable()) {
         clearSelectionGroup();
         m_selectedEdge = nullptr;
         m_dragAndDropNode = nullptr;
-        saveRedoPoint();
-        m_mindMapData = m_undoStack.undo();
+        result = m_undoStack.undo(*m_mindMapData);
         setIsModified(true);
         sendUndoAndRedoSignals();
     }
+    return result;
 }
 
 bool EditorData::isRedoable() const
@@ -104,17 +163,19 @@ bool EditorData::isRedoable() const
     return m_undoStack.isRedoable();
 }
 
-void EditorData::redo()
+UndoCommand::Result EditorData::redo()
 {
+    UndoCommand::Result result;
     if (m_undoStack.isRedoable()) {
         clearSelectionGroup();
         m_selectedEdge = nullptr;
         m_dragAndDropNode = nullptr;
         saveUndoPoint(true);
-        m_mindMapData = m_undoStack.redo();
+        result = m_undoStack.redo(*m_mindMapData);
         setIsModified(true);
         sendUndoAndRedoSignals();
     }
+    return result;
 }
 
 bool EditorData::saveMindMap()
@@ -131,6 +192,7 @@ void EditorData::saveUndoPoint(bool dontClearRedoStack)
         if (m_undoTimer.isActive()) {
             L().debug() << "Saving undo point skipped..";
             m_undoTimer.start();
+            setIsModified(true);
             return;
         }
         L().debug() << "Saving undo point..";
@@ -146,22 +208,100 @@ void EditorData::saveUndoPoint(bool dontClearRedoStack)
     sendUndoAndRedoSignals();
 }
 
-void EditorData::saveRedoPoint()
+void EditorData::saveSnapshot()
+{
+    if (m_mindMapData && Settings::loadIncrementalSave()) {
+        m_savedSnapshot = AlzJournal::snapshot(*m_mindMapData, m_fileName);
+    } else {
+        m_savedSnapshot = {};
+    }
+}
+
+void EditorData::saveUndoHistory()
 {
-    L().debug() << "Saving redo point..";
+    if (!TestMode::enabled() && Settings::loadPersistUndoHistory()) {
+        m_undoStack.save(m_fileName, *m_mindMapData);
+    }
+}
 
-    assert(m_mindMapData);
-    m_undoStack.pushRedoPoint(*m_mindMapData);
-    setIsModified(true);
-    sendUndoAndRedoSignals();
+// Appends the changes since the last save to the journal unless it's time to fold the journal into a full save
+bool EditorData::saveJournal()
+{
+    AlzJournal::Snapshot snapshot;
+    QByteArray records;
+    if (!AlzJournal::diff(*m_mindMapData, m_fileName, m_savedSnapshot, snapshot, records)) {
+        return false;
+    }
+
+    const auto foldSize = std::max(Constants::Application::JOURNAL_MIN_FOLD_SIZE, QFileInfo(m_fileName).size() * Constants::Application::JOURNAL_FOLD_PERCENT / 100);
+    if (AlzJournal::size(m_fileName) + records.size() > foldSize) {
+        L().debug() << "Folding journal..";
+        return false;
+    }
+
+    if (!records.isEmpty() && !AlzJournal::append(m_fileName, records)) {
+        return false;
+    }
+
+    L().debug() << "Journaled " << records.size() << " bytes";
+    m_savedSnapshot = std::move(snapshot);
+    return true;
+}
+
+// Encodes the images that are not encoded yet, so that the encoded forms can be cached for the next save
+static void encodeImages(MindMapState & state)
+{
+    std::map<size_t, QByteArray> encoded;
+    for (auto && image : state.images) {
+        auto && base64 = encoded[image.second.id()];
+        if (base64.isEmpty()) {
+            base64 = image.second.base64Data().isEmpty() ? image.second.data().toBase64(QByteArray::Base64Encoding) : image.second.base64Data();
+        }
+        image.second.setBase64Data(base64);
+    }
+}
+
+static bool writeMindMap(MindMapState & state, QString fileName)
+{
+    if (fileName.endsWith(Constants::Application::BINARY_FILE_EXTENSION)) {
+        return AlzbSerializer::writeToFile(state, fileName);
+    }
+
+    encodeImages(state);
+    const bool compress = fileName.endsWith(Constants::Application::COMPRESSED_FILE_EXTENSION);
+    return XmlWriter::writeToFile(fileName, [&state](QXmlStreamWriter & writer) {
+        AlzSerializer::toXml(state, writer);
+    }, compress);
+}
+
+void EditorData::cacheEncodedImages(const MindMapState & state)
+{
+    if (m_mindMapData) {
+        for (auto && image : state.images) {
+            m_mindMapData->imageManager().setBase64Data(image.second);
+        }
+    }
 }
 
 bool EditorData::saveMindMapAs(QString fileName)
 {
     assert(m_mindMapData);
 
-    if (XmlWriter::writeToFile(AlzSerializer::toXml(*m_mindMapData), fileName)) {
+    finishSave();
+
+    if (!TestMode::enabled() && fileName == m_fileName && Settings::loadIncrementalSave() && saveJournal()) {
+        saveUndoHistory();
+        setIsModified(false);
+        return true;
+    }
+
+    auto state = MindMapState::captureForSaving(*m_mindMapData);
+    if (writeMindMap(state, fileName)) {
+        cacheEncodedImages(state);
+        AlzJournal::remove(fileName);
         m_fileName = fileName;
+        saveSnapshot();
+        saveUndoHistory();
         setIsModified(false);
         RecentFilesManager::instance().addRecentFile(fileName);
         return true;
@@ -170,6 +310,89 @@ bool EditorData::saveMindMapAs(QString fileName)
     return false;
 }
 
+unsigned int EditorData::revision() const
+{
+    return m_revision;
+}
+
+void EditorData::saveMindMapAsync()
+{
+    assert(!m_fileName.isEmpty());
+
+    saveMindMapAsAsync(m_fileName);
+}
+
+void EditorData::saveMindMapAsAsync(QString fileName)
+{
+    assert(m_mindMapData);
+
+    finishSave();
+
+    // Appending to the journal is proportional to the edit, so it's done right away
+    if (!TestMode::enabled() && fileName == m_fileName && Settings::loadIncrementalSave() && saveJournal()) {
+        saveUndoHistory();
+        setIsModified(false);
+        emit saveFinished(true, fileName);
+        return;
+    }
+
+    L().debug() << "Saving '" << fileName.toStdString() << "' in the background..";
+
+    // Only plain data is captured on this thread and the worker never touches the graphics items
+    m_saveState = std::make_unique<MindMapState>(MindMapState::captureForSaving(*m_mindMapData));
+    m_saveFileName = fileName;
+    m_saveRevision = m_revision;
+    const auto state = m_saveState.get();
+    const bool takeSnapshot = Settings::loadIncrementalSave();
+    m_saveResult = WorkerPool::run(m_savePool, [this, state, fileName, takeSnapshot] {
+        SaveResult result;
+        try {
+            result.saved = writeMindMap(*state, fileName);
+            if (result.saved && takeSnapshot) {
+                result.snapshot = AlzJournal::snapshot(*state, fileName);
+            }
+        } catch (const std::exception & e) {
+            L().error() << "Saving '" << fileName.toStdString() << "' failed: " << e.what();
+            result.saved = false;
+        }
+        QMetaObject::invokeMethod(this, "handleSaveDone", Qt::QueuedConnection);
+        return result;
+    });
+}
+
+void EditorData::handleSaveDone()
+{
+    // A save started meanwhile has already handled this result, and the save in progress now must not be waited for
+    if (m_saveResult.valid() && m_saveResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        finishSave();
+    }
+}
+
+void EditorData::finishSave()
+{
+    // Waits for a save in progress, if any
+    if (!m_saveResult.valid()) {
+        return;
+    }
+
+    auto result = m_saveResult.get();
+    if (result.saved) {
+        cacheEncodedImages(*m_saveState);
+        AlzJournal::remove(m_saveFileName);
+        m_fileName = m_saveFileName;
+        m_savedSnapshot = std::move(result.snapshot);
+        // Edits made during the write are not in the file, so neither is their history saved
+        if (m_saveRevision == m_revision) {
+            saveUndoHistory();
+            setIsModified(false);
+        }
+        RecentFilesManager::instance().addRecentFile(m_saveFileName);
+    }
+    m_saveState.reset();
+
+    emit saveFinished(result.saved, m_saveFileName);
+}
+
 void EditorData::setMindMapData(MindMapDataPtr mindMapData)
 {
     m_mindMapData = mindMapData;
@@ -178,6 +401,8 @@ void EditorData::setMindMapData(MindMapDataPtr mindMapData)
     setIsModified(false);
 
     m_undoStack.clear();
+
+    emit mindMapDataChanged();
 }
 
 void EditorData::toggleNodeInSelectionGroup(Node & node)
@@ -293,10 +518,19 @@ void EditorData::sendUndoAndRedoSignals()
 
 void EditorData::setIsModified(bool isModified)
 {
+    if (isModified) {
+        m_revision++;
+    }
+
     if (isModified != m_isModified) {
         m_isModified = isModified;
         emit isModifiedChanged(isModified);
     }
 }
 
-EditorData::~EditorData() = default;
+EditorData::~EditorData()
+{
+    if (m_saveResult.valid()) {
+        m_saveResult.wait();
+    }
+}
@@ -16,6 +16,7 @@
 #ifndef EDITOR_DATA_HPP
 #define EDITOR_DATA_HPP
 
+#include <future>
 #include <memory>
 #include <set>
 #include <vector>
@@ -23,8 +24,10 @@
 #include <QObject>
 #include <QPointF>
 #include <QString>
+#include <QThreadPool>
 #include <QTimer>
 
+#include "alz_journal.hpp"
 #include "edge.hpp"
 #include "file_exception.hpp"
 #include "mind_map_data.hpp"
@@ -79,19 +82,30 @@ public:
 
     void loadMindMapData(QString fileName);
 
+    //! Loads an autosaved copy of the given file. The result is marked as modified.
+    void recoverMindMapData(QString recoveryFileName, QString fileName);
+
     MindMapDataPtr mindMapData();
 
     void moveSelectionGroup(Node & reference, QPointF location);
 
-    void redo();
+    //! \return The changes that the scene needs to be updated with.
+    UndoCommand::Result redo();
+
+    //! Changes every time the mind map gets modified.
+    unsigned int revision() const;
 
     bool saveMindMap();
 
     bool saveMindMapAs(QString fileName);
 
-    void saveUndoPoint(bool dontClearRedoStack = false);
+    //! Captures the mind map as plain data and writes it on a worker thread so that editing can continue.
+    //! Emits saveFinished() when done. Edits made meanwhile keep the mind map modified.
+    void saveMindMapAsync();
 
-    void saveRedoPoint();
+    void saveMindMapAsAsync(QString fileName);
+
+    void saveUndoPoint(bool dontClearRedoStack = false);
 
     void setMindMapData(MindMapDataPtr newMindMapData);
 
@@ -107,7 +121,8 @@ public:
 
     void toggleNodeInSelectionGroup(Node & node);
 
-    void undo();
+    //! \return The changes that the scene needs to be updated with.
+    UndoCommand::Result undo();
 
 signals:
 
@@ -117,12 +132,35 @@ signals:
 
     void redoEnabled(bool enable);
 
+    void saveFinished(bool success, QString fileName);
+
+    //! Emitted when another mind map replaces the current one.
+    void mindMapDataChanged();
+
+private slots:
+
+    void handleSaveDone();
+
 private:
     EditorData(const EditorData & e) = delete;
     EditorData & operator=(const EditorData & e) = delete;
 
+    //! Waits for a save in progress, if any, and applies its result.
+    void finishSave();
+
+    //! Keeps the images encoded while saving encoded for the next save.
+    void cacheEncodedImages(const MindMapState & state);
+
+    void readMindMapData(QString fileName);
+
     void removeNodesFromScene();
 
+    bool saveJournal();
+
+    void saveSnapshot();
+
+    void saveUndoHistory();
+
     void sendUndoAndRedoSignals();
 
     void setIsModified(bool isModified);
@@ -151,6 +189,29 @@ private:
 
     QString m_fileName;
 
+    AlzJournal::Snapshot m_savedSnapshot;
+
+    struct SaveResult
+    {
+        bool saved = false;
+
+        AlzJournal::Snapshot snapshot;
+    };
+
+    std::unique_ptr<MindMapState> m_saveState;
+
+    QString m_saveFileName;
+
+    std::future<SaveResult> m_saveResult;
+
+    //! Incremented on every modification so that a finished save knows if it's still up-to-date
+    unsigned int m_revision = 0;
+
+    unsigned int m_saveRevision = 0;
+
+    //! Not the global pool, because a save may wait for compression jobs on the global pool.
+    QThreadPool m_savePool;
+
     QTimer m_undoTimer;
 };
 
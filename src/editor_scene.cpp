@@ -17,7 +17,7 @@
 
 #include "constants.hpp"
 #include "edge.hpp"
-#include "magic_zoom.hpp"
+#include "edge_update_scheduler.hpp"
 #include "node.hpp"
 
 #include "simple_logger.hpp"
@@ -56,20 +56,24 @@ EditorScene::EditorScene()
     m_ownItems.push_back(ItemPtr(bottomLine));
 }
 
-QRectF EditorScene::zoomToFit(bool isForExport) const
+void EditorScene::addEdge(Edge & edge)
 {
-    return MagicZoom::calculateRectangle(*this, isForExport);
+    addItem(&edge);
+    m_edges[{ edge.sourceNode().index(), edge.targetNode().index() }] = &edge;
 }
 
 bool EditorScene::hasEdge(Node & node0, Node & node1)
 {
-    for (auto && item : items()) {
-        if (auto edge = dynamic_cast<Edge *>(item)) {
-            if (edge->sourceNode().index() == node0.index() && edge->targetNode().index() == node1.index()) {
-                return true;
-            }
-        }
+    const auto iter = m_edges.find({ node0.index(), node1.index() });
+    if (iter == m_edges.end()) {
+        return false;
+    }
+
+    if (iter->second && iter->second->scene() == this) {
+        return true;
     }
+
+    m_edges.erase(iter);
     return false;
 }
 
@@ -86,6 +90,8 @@ void EditorScene::removeItems()
 
 QImage EditorScene::toImage(QSize size, QColor backgroundColor, bool transparentBackground)
 {
+    EdgeUpdateScheduler::instance().flush();
+
     QImage image(size, QImage::Format_ARGB32);
     image.fill(transparentBackground ? Qt::transparent : backgroundColor);
 
@@ -99,6 +105,8 @@ QImage EditorScene::toImage(QSize size, QColor backgroundColor, bool transparent
 
 void EditorScene::toSvg(QString filename, QString title)
 {
+    EdgeUpdateScheduler::instance().flush();
+
     // Need to disable effects in order to get vectorized SVG.
     // Otherwise all items will be just bitmapped.
     for (auto && item : items()) {
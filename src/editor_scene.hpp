@@ -16,10 +16,14 @@
 #ifndef EDITOR_SCENE_HPP
 #define EDITOR_SCENE_HPP
 
+#include <map>
 #include <memory>
+#include <utility>
 
 #include <QGraphicsScene>
+#include <QPointer>
 
+class Edge;
 class Node;
 
 class EditorScene : public QGraphicsScene
@@ -27,7 +31,8 @@ class EditorScene : public QGraphicsScene
 public:
     EditorScene();
 
-    QRectF zoomToFit(bool isForExport = false) const;
+    //! Adds the edge item and indexes it by the indices of its nodes
+    void addEdge(Edge & edge);
 
     //! Checks if the graphics scene already has the given edge item added
     bool hasEdge(Node & node0, Node & node1);
@@ -43,6 +48,9 @@ private:
 
     using ItemPtr = std::unique_ptr<QGraphicsItem>;
     std::vector<ItemPtr> m_ownItems;
+
+    //! Edges added with addEdge(). Deleted and removed edges are dropped when looked up.
+    std::map<std::pair<int, int>, QPointer<Edge>> m_edges;
 };
 
 #endif // EDITOR_SCENE_HPP
@@ -31,6 +31,7 @@ Graph::Graph()
 
 void Graph::clear()
 {
+    m_spatialIndex.clear();
     m_nodes.clear();
 }
 
@@ -45,6 +46,7 @@ void Graph::addNode(NodePtr node)
     }
 
     m_nodes.push_back(node);
+    m_spatialIndex.insert(*node);
 }
 
 void Graph::deleteEdge(int index0, int index1)
@@ -83,6 +85,7 @@ void Graph::deleteNode(int index)
             }
         } while (edgeErased);
 
+        m_spatialIndex.remove(**iter);
         m_nodes.erase(iter);
     }
 }
@@ -99,6 +102,20 @@ void Graph::addEdge(EdgePtr newEdge)
     }
 }
 
+void Graph::replace(NodeVector nodes, EdgeVector edges)
+{
+    // Ensure that edges are always deleted before nodes
+    m_edges.clear();
+    m_spatialIndex.clear();
+    m_nodes.clear();
+
+    for (auto && node : nodes) {
+        addNode(node);
+    }
+
+    m_edges = std::move(edges);
+}
+
 bool Graph::areDirectlyConnected(NodePtr node0, NodePtr node1)
 {
     for (auto && edge : m_edges) {
@@ -175,10 +192,16 @@ Graph::NodeVector Graph::getNodesConnectedToNode(NodePtr node)
     return result;
 }
 
+const SpatialIndex & Graph::spatialIndex() const
+{
+    return m_spatialIndex;
+}
+
 Graph::~Graph()
 {
     // Ensure that edges are always deleted before nodes
     m_edges.clear();
+    m_spatialIndex.clear();
     m_nodes.clear();
 
     juzzlin::L().debug() << "Graph deleted";
@@ -18,6 +18,7 @@
 
 #include "edge.hpp"
 #include "node.hpp"
+#include "spatial_index.hpp"
 
 #include <map>
 #include <set>
@@ -49,6 +50,9 @@ public:
 
     void deleteEdge(int index0, int index1);
 
+    //! Replaces all nodes and edges at once, e.g. after applying many changes. The edges must be unique.
+    void replace(NodeVector nodes, EdgeVector edges);
+
     bool areDirectlyConnected(NodePtr node0, NodePtr node1);
 
     size_t numNodes() const;
@@ -65,11 +69,16 @@ public:
 
     NodeVector getNodesConnectedToNode(NodePtr node);
 
+    //! Nodes by their location, kept up-to-date as the nodes move.
+    const SpatialIndex & spatialIndex() const;
+
 private:
     NodeVector m_nodes;
 
     EdgeVector m_edges;
 
+    SpatialIndex m_spatialIndex;
+
     int m_count = 0;
 };
 
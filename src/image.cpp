@@ -15,19 +15,16 @@
 
 #include "image.hpp"
 
-Image::Image()
-{
-}
+#include <QCryptographicHash>
 
-Image::Image(QImage image, std::string path)
-  : m_image(image)
-  , m_path(path)
+Image::Image()
 {
 }
 
-QImage Image::image() const
+Image::Image(QByteArray data, std::string path)
+  : m_path(path)
 {
-    return m_image;
+    setData(data);
 }
 
 std::string Image::path() const
@@ -44,3 +41,35 @@ void Image::setId(size_t id)
 {
     m_id = id;
 }
+
+QByteArray Image::data() const
+{
+    return m_data;
+}
+
+void Image::setData(QByteArray data)
+{
+    m_data = data;
+    m_hash = data.isEmpty() ? std::string {} : contentHash(data);
+    m_base64Data.clear();
+}
+
+QByteArray Image::base64Data() const
+{
+    return m_base64Data;
+}
+
+void Image::setBase64Data(QByteArray base64Data)
+{
+    m_base64Data = base64Data;
+}
+
+std::string Image::hash() const
+{
+    return m_hash;
+}
+
+std::string Image::contentHash(const QByteArray & data)
+{
+    return QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex().toStdString();
+}
@@ -16,7 +16,7 @@
 #ifndef IMAGE_HPP
 #define IMAGE_HPP
 
-#include <QImage>
+#include <QByteArray>
 
 #include <string>
 
@@ -25,9 +25,7 @@ class Image
 public:
     Image();
 
-    Image(QImage image, std::string path);
-
-    QImage image() const;
+    Image(QByteArray data, std::string path);
 
     std::string path() const;
 
@@ -35,12 +33,32 @@ public:
 
     void setId(size_t id);
 
-private:
-    QImage m_image;
+    //! The original encoded (compressed) image data. Empty if only the path is known.
+    QByteArray data() const;
+
+    //! Also updates the content hash and drops the cached base64 form.
+    void setData(QByteArray data);
+
+    //! Cached base64 form of data(). Empty if not yet encoded.
+    QByteArray base64Data() const;
+
+    void setBase64Data(QByteArray base64Data);
+
+    //! Content hash of the encoded image data. Empty if unknown.
+    std::string hash() const;
 
+    static std::string contentHash(const QByteArray & data);
+
+private:
     std::string m_path;
 
     size_t m_id = 0;
+
+    std::string m_hash;
+
+    QByteArray m_data;
+
+    QByteArray m_base64Data;
 };
 
 #endif // IMAGE_HPP
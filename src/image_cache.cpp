@@ -0,0 +1,168 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "image_cache.hpp"
+
+#include "image.hpp"
+#include "settings.hpp"
+#include "simple_logger.hpp"
+
+#include <QBuffer>
+#include <QImageReader>
+
+#include <algorithm>
+#include <stdexcept>
+
+std::unique_ptr<ImageCache> ImageCache::m_instance;
+
+ImageCache::ImageCache()
+  : m_budget(static_cast<qint64>(Settings::loadImageCacheSizeMb()) * 1024 * 1024)
+{
+    if (ImageCache::m_instance) {
+        throw std::runtime_error("ImageCache already instantiated!");
+    }
+}
+
+ImageCache & ImageCache::instance()
+{
+    if (!ImageCache::m_instance) {
+        ImageCache::m_instance = std::make_unique<ImageCache>();
+        juzzlin::L().debug() << "ImageCache created, budget=" << ImageCache::m_instance->budget() << " bytes";
+    }
+
+    return *ImageCache::m_instance;
+}
+
+QPixmap ImageCache::pixmap(const Image & image, QSize targetSize)
+{
+    if (image.data().isEmpty()) {
+        return {};
+    }
+
+    const auto size = originalSize(image);
+    if (!size.isValid()) {
+        return {};
+    }
+
+    const Key key { image.hash(), mipLevel(size, targetSize) };
+    const auto iter = m_entries.find(key);
+    if (iter != m_entries.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, iter->second.lruPosition);
+        return iter->second.pixmap;
+    }
+
+    const auto pixmap = decode(image, size, key.second);
+    if (!pixmap.isNull()) {
+        insert(key, pixmap);
+    }
+    return pixmap;
+}
+
+void ImageCache::setBudget(qint64 bytes)
+{
+    m_budget = bytes;
+    evict();
+}
+
+qint64 ImageCache::budget() const
+{
+    return m_budget;
+}
+
+qint64 ImageCache::usage() const
+{
+    return m_usage;
+}
+
+void ImageCache::clear()
+{
+    m_entries.clear();
+    m_lru.clear();
+    m_originalSizes.clear();
+    m_usage = 0;
+}
+
+QSize ImageCache::originalSize(const Image & image)
+{
+    const auto iter = m_originalSizes.find(image.hash());
+    if (iter != m_originalSizes.end()) {
+        return iter->second;
+    }
+
+    // Only the header is read here, unless the format can't tell the size without decoding
+    auto data = image.data();
+    QBuffer buffer(&data);
+    QImageReader reader(&buffer);
+    auto size = reader.size();
+    if (!size.isValid()) {
+        size = reader.read().size();
+    }
+    m_originalSizes[image.hash()] = size;
+    return size;
+}
+
+int ImageCache::mipLevel(QSize originalSize, QSize targetSize) const
+{
+    int level = 0;
+    while (originalSize.width() / 2 >= targetSize.width() && originalSize.height() / 2 >= targetSize.height() && originalSize.width() > 1 && originalSize.height() > 1) {
+        originalSize /= 2;
+        level++;
+    }
+    return level;
+}
+
+QPixmap ImageCache::decode(const Image & image, QSize originalSize, int level) const
+{
+    auto data = image.data();
+    QBuffer buffer(&data);
+    QImageReader reader(&buffer);
+    if (level) {
+        // Lets e.g. the JPEG decoder skip most of the work instead of scaling a full-size image down
+        reader.setScaledSize(QSize { std::max(1, originalSize.width() >> level), std::max(1, originalSize.height() >> level) });
+    }
+
+    const auto decoded = reader.read();
+    if (decoded.isNull()) {
+        juzzlin::L().warning() << "Cannot decode image id=" << image.id() << ": " << reader.errorString().toStdString();
+        return {};
+    }
+
+    juzzlin::L().debug() << "Decoded image id=" << image.id() << " at mip level " << level << ": " << decoded.width() << "x" << decoded.height();
+    return QPixmap::fromImage(decoded);
+}
+
+void ImageCache::insert(const Key & key, QPixmap pixmap)
+{
+    m_lru.push_front(key);
+    Entry entry;
+    entry.pixmap = pixmap;
+    entry.cost = static_cast<qint64>(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+    entry.lruPosition = m_lru.begin();
+    m_usage += entry.cost;
+    m_entries[key] = entry;
+
+    evict();
+}
+
+void ImageCache::evict()
+{
+    // The most recently used entry is kept even if it alone exceeds the budget
+    while (m_usage > m_budget && m_lru.size() > 1) {
+        const auto iter = m_entries.find(m_lru.back());
+        m_usage -= iter->second.cost;
+        m_entries.erase(iter);
+        m_lru.pop_back();
+    }
+}
@@ -0,0 +1,87 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef IMAGE_CACHE_HPP
+#define IMAGE_CACHE_HPP
+
+#include <QPixmap>
+#include <QSize>
+
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+class Image;
+
+//! Decodes images lazily from their encoded data at power-of-two mip levels and keeps
+//! the resulting pixmaps in an LRU cache limited by a byte budget.
+class ImageCache
+{
+public:
+    ImageCache();
+
+    static ImageCache & instance();
+
+    //! \return pixmap of the smallest mip level that still covers the given size in device pixels.
+    QPixmap pixmap(const Image & image, QSize targetSize);
+
+    void setBudget(qint64 bytes);
+
+    qint64 budget() const;
+
+    qint64 usage() const;
+
+    void clear();
+
+private:
+    using Key = std::pair<std::string, int>;
+
+    using LruList = std::list<Key>;
+
+    struct Entry
+    {
+        QPixmap pixmap;
+
+        qint64 cost = 0;
+
+        LruList::iterator lruPosition;
+    };
+
+    QSize originalSize(const Image & image);
+
+    int mipLevel(QSize originalSize, QSize targetSize) const;
+
+    QPixmap decode(const Image & image, QSize originalSize, int level) const;
+
+    void insert(const Key & key, QPixmap pixmap);
+
+    void evict();
+
+    static std::unique_ptr<ImageCache> m_instance;
+
+    std::map<Key, Entry> m_entries;
+
+    LruList m_lru;
+
+    std::map<std::string, QSize> m_originalSizes;
+
+    qint64 m_budget;
+
+    qint64 m_usage = 0;
+};
+
+#endif // IMAGE_CACHE_HPP
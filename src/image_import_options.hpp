@@ -0,0 +1,36 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef IMAGE_IMPORT_OPTIONS_HPP
+#define IMAGE_IMPORT_OPTIONS_HPP
+
+#include <QString>
+
+#include "constants.hpp"
+
+//! How images are downscaled and transcoded on import. Stored per mind map.
+struct ImageImportOptions
+{
+    //! Maximum width or height in pixels, 0 means unlimited.
+    int maxSize = Constants::ImageImport::DEFAULT_MAX_SIZE;
+
+    //! Target format (e.g. "jpg", "png", "webp"), empty means keep the original format.
+    QString format;
+
+    //! Encoder quality 0..100, -1 means the encoder default.
+    int quality = Constants::ImageImport::DEFAULT_QUALITY;
+};
+
+#endif // IMAGE_IMPORT_OPTIONS_HPP
@@ -0,0 +1,152 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "image_importer.hpp"
+
+#include "simple_logger.hpp"
+#include "worker_pool.hpp"
+
+#include <QBuffer>
+#include <QFile>
+#include <QImageReader>
+#include <QImageWriter>
+
+#include <algorithm>
+#include <chrono>
+
+ImageImporter::ImageImporter()
+{
+    qRegisterMetaType<Image>("Image");
+}
+
+ImageImporter::~ImageImporter()
+{
+    for (auto && import : m_imports) {
+        import.wait();
+    }
+}
+
+void ImageImporter::import(QString fileName, ImageImportOptions options, int nodeIndex)
+{
+    m_imports.erase(std::remove_if(m_imports.begin(), m_imports.end(), [](const std::future<void> & import) {
+                        return import.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                    }),
+                    m_imports.end());
+
+    // The result is handed to the thread of this object, which drops it if discarded meanwhile
+    const auto generation = m_generation;
+    m_imports.push_back(WorkerPool::run([this, fileName, options, nodeIndex, generation] {
+        const auto image = ImageImporter::transcode(fileName, options);
+        QMetaObject::invokeMethod(this, "finishImport", Qt::QueuedConnection,
+                                  Q_ARG(Image, image), Q_ARG(QString, fileName), Q_ARG(int, nodeIndex), Q_ARG(unsigned int, generation));
+    }));
+}
+
+void ImageImporter::discardPending()
+{
+    m_generation++;
+}
+
+void ImageImporter::finishImport(Image image, QString fileName, int nodeIndex, unsigned int generation)
+{
+    if (generation != m_generation) {
+        juzzlin::L().debug() << "Discarding imported image '" << fileName.toStdString() << "'";
+        return;
+    }
+
+    if (!image.data().isEmpty()) {
+        emit imported(image, nodeIndex);
+    } else {
+        emit importFailed(fileName, nodeIndex);
+    }
+}
+
+static QString outputFormat(QString requestedFormat, QByteArray originalFormat)
+{
+    const auto supportedFormats = QImageWriter::supportedImageFormats();
+    if (!requestedFormat.isEmpty()) {
+        if (supportedFormats.contains(requestedFormat.toLatin1())) {
+            return requestedFormat;
+        }
+        juzzlin::L().warning() << "Image format '" << requestedFormat.toStdString() << "' not supported, using png";
+        return "png";
+    }
+    return supportedFormats.contains(originalFormat) ? QString(originalFormat) : QString("png");
+}
+
+// Different names of the same format, e.g. "jpg" and "jpeg", compare equal after this
+static QByteArray normalizedFormat(QByteArray format)
+{
+    format = format.toLower();
+    if (format == "jpg") {
+        return "jpeg";
+    }
+    if (format == "tif") {
+        return "tiff";
+    }
+    return format;
+}
+
+Image ImageImporter::transcode(QString fileName, ImageImportOptions options)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        juzzlin::L().error() << "Cannot open image '" << fileName.toStdString() << "'";
+        return {};
+    }
+
+    auto original = file.readAll();
+    QBuffer originalBuffer(&original);
+    QImageReader reader(&originalBuffer);
+    reader.setAutoTransform(true);
+    const auto originalFormat = reader.format();
+    auto size = reader.size();
+    if (!reader.canRead() || !size.isValid()) {
+        juzzlin::L().error() << "Cannot read image '" << fileName.toStdString() << "': " << reader.errorString().toStdString();
+        return {};
+    }
+
+    const bool needsScaling = options.maxSize > 0 && std::max(size.width(), size.height()) > options.maxSize;
+    const bool needsTranscoding = !options.format.isEmpty() && normalizedFormat(options.format.toLatin1()) != normalizedFormat(originalFormat);
+    if (!needsScaling && !needsTranscoding) {
+        juzzlin::L().debug() << "Importing image '" << fileName.toStdString() << "' as is";
+        return { original, fileName.toStdString() };
+    }
+
+    if (needsScaling) {
+        size.scale(options.maxSize, options.maxSize, Qt::KeepAspectRatio);
+        reader.setScaledSize(size);
+    }
+
+    const auto decoded = reader.read();
+    if (decoded.isNull()) {
+        juzzlin::L().error() << "Cannot decode image '" << fileName.toStdString() << "': " << reader.errorString().toStdString();
+        return {};
+    }
+
+    QByteArray transcoded;
+    QBuffer transcodedBuffer(&transcoded);
+    transcodedBuffer.open(QIODevice::WriteOnly);
+    QImageWriter writer(&transcodedBuffer, outputFormat(options.format, originalFormat).toLatin1());
+    writer.setQuality(options.quality);
+    if (!writer.write(decoded)) {
+        juzzlin::L().error() << "Cannot encode image '" << fileName.toStdString() << "': " << writer.errorString().toStdString();
+        return {};
+    }
+
+    juzzlin::L().info() << "Imported image '" << fileName.toStdString() << "': " << original.size() << " => " << transcoded.size() << " bytes, "
+                        << decoded.width() << "x" << decoded.height();
+    return { transcoded, fileName.toStdString() };
+}
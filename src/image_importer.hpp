@@ -0,0 +1,69 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef IMAGE_IMPORTER_HPP
+#define IMAGE_IMPORTER_HPP
+
+#include <QObject>
+#include <QString>
+
+#include "image.hpp"
+#include "image_import_options.hpp"
+
+#include <future>
+#include <vector>
+
+//! Reads, downscales and transcodes images on the worker pool before they are embedded into the mind map.
+class ImageImporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    ImageImporter();
+
+    //! Waits for running imports, as they refer to this object.
+    ~ImageImporter();
+
+    //! Results are delivered via imported() or importFailed() in the thread of this object.
+    //! \param nodeIndex Index of the node that gets the image, echoed back with the result.
+    void import(QString fileName, ImageImportOptions options, int nodeIndex);
+
+    //! Synchronous version of import(). \return image with empty data on failure.
+    static Image transcode(QString fileName, ImageImportOptions options);
+
+public slots:
+
+    //! Drops the results of the imports started so far, e.g. when another mind map is opened.
+    void discardPending();
+
+signals:
+
+    void imported(Image image, int nodeIndex);
+
+    void importFailed(QString fileName, int nodeIndex);
+
+private slots:
+
+    void finishImport(Image image, QString fileName, int nodeIndex, unsigned int generation);
+
+private:
+    std::vector<std::future<void>> m_imports;
+
+    unsigned int m_generation = 0;
+};
+
+Q_DECLARE_METATYPE(Image)
+
+#endif // IMAGE_IMPORTER_HPP
@@ -25,15 +25,27 @@ void ImageManager::clear()
 {
     juzzlin::L().debug() << "Clearing ImageManager";
 
+    std::lock_guard<std::mutex> lock(m_mutex);
     m_images.clear();
+    m_aliases.clear();
+    m_hashes.clear();
     m_count = 0;
 }
 
 size_t ImageManager::addImage(const Image & image)
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (const auto existingId = findImage(image.hash())) {
+        juzzlin::L().debug() << "Reusing image, path=" << image.path() << ", id=" << existingId;
+        return existingId;
+    }
+
     const auto id = ++m_count;
     m_images[id] = image;
     m_images[id].setId(id);
+    if (!image.hash().empty()) {
+        m_hashes[image.hash()] = id;
+    }
 
     juzzlin::L().debug() << "Adding new image, path=" << image.path() << ", id=" << id;
 
@@ -42,24 +54,52 @@ size_t ImageManager::addImage(const Image & image)
 
 void ImageManager::setImage(const Image & image)
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
     if (!image.id()) {
         throw std::runtime_error("Image must have id > 0 !");
     }
 
     m_count = std::max(image.id(), m_count);
+
+    const auto existingId = findImage(image.hash());
+    if (existingId && existingId != image.id()) {
+        juzzlin::L().debug() << "Aliasing image, path=" << image.path() << ", id=" << image.id() << " to id=" << existingId;
+        m_aliases[image.id()] = existingId;
+        return;
+    }
+
+    m_aliases.erase(image.id());
     m_images[image.id()] = image;
+    if (!image.hash().empty()) {
+        m_hashes[image.hash()] = image.id();
+    }
 
     juzzlin::L().debug() << "Setting image, path=" << image.path() << ", id=" << image.id();
 }
 
-std::pair<Image, bool> ImageManager::getImage(size_t id)
+std::pair<Image, bool> ImageManager::getImage(size_t id) const
 {
-    if (m_images.count(id)) {
-        return { m_images[id], true };
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto alias = m_aliases.find(id);
+    if (alias != m_aliases.end()) {
+        id = alias->second;
+    }
+    const auto iter = m_images.find(id);
+    if (iter != m_images.end()) {
+        return { iter->second, true };
     }
     return {};
 }
 
+void ImageManager::setBase64Data(const Image & image)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto iter = m_images.find(image.id());
+    if (iter != m_images.end() && iter->second.hash() == image.hash() && iter->second.base64Data().isEmpty()) {
+        iter->second.setBase64Data(image.base64Data());
+    }
+}
+
 void ImageManager::handleImageRequest(size_t id, Node & node)
 {
     const auto && imagePair = getImage(id);
@@ -71,8 +111,20 @@ void ImageManager::handleImageRequest(size_t id, Node & node)
     }
 }
 
+size_t ImageManager::findImage(std::string hash) const
+{
+    if (!hash.empty()) {
+        const auto iter = m_hashes.find(hash);
+        if (iter != m_hashes.end()) {
+            return iter->second;
+        }
+    }
+    return 0;
+}
+
 ImageManager::ImageVector ImageManager::images() const
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
     ImageVector images;
     for (auto && image : m_images) {
         images.push_back(image.second);
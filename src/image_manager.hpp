@@ -19,11 +19,13 @@
 #include <QObject>
 
 #include <map>
+#include <mutex>
 
 #include "image.hpp"
 
 class Node;
 
+//! Thread-safe, as mind maps may be serialized on a worker thread while being edited.
 class ImageManager : public QObject
 {
     Q_OBJECT
@@ -33,11 +35,18 @@ public:
 
     void clear();
 
+    //! \return id of an existing image with the same content hash, if any.
     size_t addImage(const Image & image);
 
+    //! An image whose content hash is already known becomes an alias of the existing image.
     void setImage(const Image & image);
 
-    std::pair<Image, bool> getImage(size_t id);
+    //! Aliases resolve to the canonical image, so the returned image id may differ from the given id.
+    std::pair<Image, bool> getImage(size_t id) const;
+
+    //! Caches the base64 form of an image that was encoded while saving, so that repeated saves
+    //! only encode images that are new since the last save. Ignored if the image has changed meanwhile.
+    void setBase64Data(const Image & image);
 
     void handleImageRequest(size_t id, Node & node);
 
@@ -45,9 +54,17 @@ public:
     ImageVector images() const;
 
 private:
+    size_t findImage(std::string hash) const;
+
     std::map<size_t, Image> m_images;
 
+    std::map<size_t, size_t> m_aliases;
+
+    std::map<std::string, size_t> m_hashes;
+
     size_t m_count = 0;
+
+    mutable std::mutex m_mutex;
 };
 
 #endif // IMAGE_MANAGER_HPP
@@ -15,24 +15,15 @@
 
 #include "magic_zoom.hpp"
 
-#include "editor_scene.hpp"
-#include "node.hpp"
+#include "spatial_index.hpp"
 
 #include <cmath>
 
-QRectF MagicZoom::calculateRectangle(const EditorScene & scene, bool isForExport)
+QRectF MagicZoom::calculateRectangle(const SpatialIndex & spatialIndex, bool isForExport)
 {
-    double nodeArea = 0;
-    QRectF rect;
-    int nodes = 0;
-    for (auto && item : scene.items()) {
-        if (auto node = dynamic_cast<Node *>(item)) {
-            const auto nodeRect = node->placementBoundingRect();
-            rect = rect.united(nodeRect.translated(node->pos().x(), node->pos().y()));
-            nodeArea += nodeRect.width() * nodeRect.height();
-            nodes++;
-        }
-    }
+    const auto nodeArea = spatialIndex.nodeArea();
+    const auto rect = spatialIndex.bounds();
+    const auto nodes = spatialIndex.size();
 
     const int margin = 60;
 
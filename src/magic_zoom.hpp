@@ -18,11 +18,11 @@
 
 #include <QRectF>
 
-class EditorScene;
+class SpatialIndex;
 
 namespace MagicZoom {
 
-QRectF calculateRectangle(const EditorScene & scene, bool isForExport);
+QRectF calculateRectangle(const SpatialIndex & spatialIndex, bool isForExport);
 
 } // namespace MagicZoom
 
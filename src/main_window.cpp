@@ -379,6 +379,22 @@ void MainWindow::createSettingsMenu()
     const auto defaultsAct = new QAction(tr("&Defaults"), this);
     connect(defaultsAct, &QAction::triggered, m_defaultsDlg, &DefaultsDlg::exec);
     settingsMenu->addAction(defaultsAct);
+
+    settingsMenu->addSeparator();
+
+    // Add "incremental save"-action
+    const auto incrementalSaveAct = new QAction(tr("Save only changes"), this);
+    incrementalSaveAct->setCheckable(true);
+    incrementalSaveAct->setChecked(Settings::loadIncrementalSave());
+    settingsMenu->addAction(incrementalSaveAct);
+    connect(incrementalSaveAct, &QAction::triggered, Settings::saveIncrementalSave);
+
+    // Add "persist undo history"-action
+    const auto persistUndoHistoryAct = new QAction(tr("Keep undo history"), this);
+    persistUndoHistoryAct->setCheckable(true);
+    persistUndoHistoryAct->setChecked(Settings::loadPersistUndoHistory());
+    settingsMenu->addAction(persistUndoHistoryAct);
+    connect(persistUndoHistoryAct, &QAction::triggered, Settings::savePersistUndoHistory);
 }
 
 void MainWindow::createToolBar()
@@ -19,17 +19,22 @@
 #include "editor_scene.hpp"
 #include "editor_view.hpp"
 #include "image_manager.hpp"
+#include "magic_zoom.hpp"
 #include "main_window.hpp"
 #include "mouse_action.hpp"
 
+#include "constants.hpp"
 #include "simple_logger.hpp"
 
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QGraphicsItem>
 #include <QGraphicsScene>
 #include <QSizePolicy>
 
+#include <algorithm>
 #include <cassert>
+#include <unordered_map>
 
 using juzzlin::L;
 
@@ -39,34 +44,54 @@ Mediator::Mediator(MainWindow & mainWindow)
     connect(&m_mainWindow, &MainWindow::zoomToFitTriggered, this, &Mediator::zoomToFit);
     connect(&m_mainWindow, &MainWindow::zoomInTriggered, this, &Mediator::zoomIn);
     connect(&m_mainWindow, &MainWindow::zoomOutTriggered, this, &Mediator::zoomOut);
+
+    m_populateTimer.setInterval(0);
+    connect(&m_populateTimer, &QTimer::timeout, this, &Mediator::populateSceneBatch);
 }
 
 void Mediator::addExistingGraphToScene()
 {
+    // Everything still waiting to be populated gets added below
+    cancelPopulatingScene();
+
     for (auto && node : m_editorData->mindMapData()->graph().getNodes()) {
         if (node->scene() != m_editorScene.get()) {
-            addItem(*node);
-            node->setCornerRadius(m_editorData->mindMapData()->cornerRadius());
-            node->setTextSize(m_editorData->mindMapData()->textSize());
-            L().debug() << "Added existing node " << node->index() << " to scene";
+            addNodeToScene(*node);
         }
     }
 
     for (auto && edge : m_editorData->mindMapData()->graph().getEdges()) {
-        const auto node0 = getNodeByIndex(edge->sourceNode().index());
-        const auto node1 = getNodeByIndex(edge->targetNode().index());
-        if (!m_editorScene->hasEdge(*node0, *node1)) {
-            addItem(*edge);
-            edge->setColor(m_editorData->mindMapData()->edgeColor());
-            edge->setWidth(m_editorData->mindMapData()->edgeWidth());
-            edge->setTextSize(m_editorData->mindMapData()->textSize());
-            node0->addGraphicsEdge(*edge);
-            node1->addGraphicsEdge(*edge);
-            edge->updateLine();
-            L().debug() << "Added existing edge " << node0->index() << " -> " << node1->index() << " to scene";
+        if (!m_editorScene->hasEdge(edge->sourceNode(), edge->targetNode())) {
+            addEdgeToScene(*edge);
         }
     }
 
+    updateWidgetsFromMindMapData();
+}
+
+void Mediator::addNodeToScene(Node & node)
+{
+    // The geometry is completed before the node enters the scene index
+    node.applyDesign(m_editorData->mindMapData()->cornerRadius(), m_editorData->mindMapData()->textSize());
+    addItem(node);
+    L().debug() << "Added node " << node.index() << " to scene";
+}
+
+void Mediator::addEdgeToScene(Edge & edge)
+{
+    // The line is calculated once, before the edge enters the scene index
+    edge.setColor(m_editorData->mindMapData()->edgeColor());
+    edge.setWidth(m_editorData->mindMapData()->edgeWidth());
+    edge.setTextSize(m_editorData->mindMapData()->textSize());
+    edge.sourceNode().addGraphicsEdge(edge);
+    edge.targetNode().addGraphicsEdge(edge);
+    edge.updateLine();
+    m_editorScene->addEdge(edge);
+    L().debug() << "Added edge " << edge.sourceNode().index() << " -> " << edge.targetNode().index() << " to scene";
+}
+
+void Mediator::updateWidgetsFromMindMapData()
+{
     // This is to prevent nasty updated loops like in https://github.com/juzzlin/Heimer/issues/96
     m_mainWindow.enableWidgetSignals(false);
 
@@ -81,13 +106,104 @@ void Mediator::addExistingGraphToScene()
     m_mainWindow.enableWidgetSignals(true);
 }
 
+void Mediator::populateSceneViewportFirst(QRectF viewRect)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Nodes in the view come first, the rest in the order of their distance to it
+    const auto center = viewRect.center();
+    const auto & nodes = m_editorData->mindMapData()->graph().getNodes();
+    std::vector<std::pair<std::pair<bool, double>, NodePtr>> sortedNodes;
+    sortedNodes.reserve(nodes.size());
+    size_t visibleNodeCount = 0;
+    for (auto && node : nodes) {
+        const auto delta = node->location() - center;
+        const auto isVisible = viewRect.contains(node->location());
+        visibleNodeCount += isVisible;
+        sortedNodes.push_back({ { !isVisible, QPointF::dotProduct(delta, delta) }, node });
+    }
+    std::stable_sort(sortedNodes.begin(), sortedNodes.end(), [](auto && lhs, auto && rhs) {
+        return lhs.first < rhs.first;
+    });
+
+    // Each edge follows the later of its nodes
+    std::unordered_map<int, size_t> nodeRanks;
+    for (auto && sortedNode : sortedNodes) {
+        nodeRanks[sortedNode.second->index()] = m_pendingNodes.size();
+        m_pendingNodes.push_back(sortedNode.second);
+    }
+    for (auto && edge : m_editorData->mindMapData()->graph().getEdges()) {
+        m_pendingEdges.push_back({ std::max(nodeRanks[edge->sourceNode().index()], nodeRanks[edge->targetNode().index()]), edge });
+    }
+    std::stable_sort(m_pendingEdges.begin(), m_pendingEdges.end(), [](auto && lhs, auto && rhs) {
+        return lhs.first < rhs.first;
+    });
+
+    populateScene(visibleNodeCount);
+    updateWidgetsFromMindMapData();
+
+    L().debug() << "Populated " << visibleNodeCount << " visible nodes of " << nodes.size() << " in " << timer.elapsed() << " ms";
+
+    if (isPopulatingScene()) {
+        m_populateTimer.start();
+    }
+}
+
+void Mediator::populateScene(size_t nodeCount)
+{
+    const auto end = std::min(m_populatedNodeCount + nodeCount, m_pendingNodes.size());
+    while (m_populatedNodeCount < end) {
+        addNodeToScene(*m_pendingNodes.at(m_populatedNodeCount++));
+    }
+
+    while (m_populatedEdgeCount < m_pendingEdges.size() && m_pendingEdges.at(m_populatedEdgeCount).first < m_populatedNodeCount) {
+        addEdgeToScene(*m_pendingEdges.at(m_populatedEdgeCount++).second);
+    }
+
+    if (m_populatedNodeCount == m_pendingNodes.size()) {
+        cancelPopulatingScene();
+    }
+}
+
+void Mediator::populateSceneBatch()
+{
+    populateScene(Constants::View::POPULATE_BATCH_SIZE);
+
+    if (!isPopulatingScene()) {
+        L().debug() << "Scene populated";
+    }
+}
+
+bool Mediator::isPopulatingScene() const
+{
+    return !m_pendingNodes.empty();
+}
+
+void Mediator::cancelPopulatingScene()
+{
+    m_populateTimer.stop();
+    m_pendingNodes.clear();
+    m_pendingEdges.clear();
+    m_populatedNodeCount = 0;
+    m_populatedEdgeCount = 0;
+}
+
+void Mediator::finishPopulatingScene()
+{
+    if (isPopulatingScene()) {
+        addExistingGraphToScene();
+    }
+}
+
 void Mediator::addEdge(Node & node1, Node & node2)
 {
     // Add edge from node1 to node2
-    connectEdgeToUndoMechanism(m_editorData->addEdge(std::make_shared<Edge>(node1, node2)));
+    const auto edge = m_editorData->addEdge(std::make_shared<Edge>(node1, node2));
+    connectEdgeToUndoMechanism(edge);
     L().debug() << "Created a new edge " << node1.index() << " -> " << node2.index();
 
-    addExistingGraphToScene();
+    addEdgeToScene(*edge);
 }
 
 void Mediator::addItem(QGraphicsItem & item)
@@ -148,10 +264,12 @@ NodePtr Mediator::createAndAddNode(int sourceNodeIndex, QPointF pos)
     L().debug() << "Created a new node at (" << pos.x() << "," << pos.y() << ")";
 
     // Add edge from the parent node.
-    connectEdgeToUndoMechanism(m_editorData->addEdge(std::make_shared<Edge>(*node0, *node1)));
+    const auto edge = m_editorData->addEdge(std::make_shared<Edge>(*node0, *node1));
+    connectEdgeToUndoMechanism(edge);
     L().debug() << "Created a new edge " << node0->index() << " -> " << node1->index();
 
-    addExistingGraphToScene();
+    addNodeToScene(*node1);
+    addEdgeToScene(*edge);
 
     node1->setTextInputActive();
 
@@ -166,7 +284,7 @@ NodePtr Mediator::createAndAddNode(QPointF pos)
     connectNodeToImageManager(node1);
     L().debug() << "Created a new node at (" << pos.x() << "," << pos.y() << ")";
 
-    addExistingGraphToScene();
+    addNodeToScene(*node1);
 
     QTimer::singleShot(0, [node1]() { // Needed due to the context menu
         node1->setTextInputActive();
@@ -183,7 +301,7 @@ NodePtr Mediator::pasteNodeAt(Node & source, QPointF pos)
     connectNodeToImageManager(copiedNode);
     L().debug() << "Pasted node at (" << pos.x() << "," << pos.y() << ")";
 
-    addExistingGraphToScene();
+    addNodeToScene(*copiedNode);
 
     QTimer::singleShot(0, [copiedNode]() { // Needed due to the context menu
         copiedNode->setTextInputActive();
@@ -199,11 +317,13 @@ MouseAction & Mediator::mouseAction()
 
 void Mediator::deleteEdge(Edge & edge)
 {
+    finishPopulatingScene();
     m_editorData->deleteEdge(edge);
 }
 
 void Mediator::deleteNode(Node & node)
 {
+    finishPopulatingScene();
     m_editorView->resetDummyDragItems();
     m_editorData->deleteNode(node);
 }
@@ -260,6 +380,7 @@ void Mediator::initializeNewMindMap()
 
     assert(m_editorData);
 
+    cancelPopulatingScene();
     m_editorScene = std::make_unique<EditorScene>();
     m_editorData->clearImages();
     m_editorData->setMindMapData(std::make_shared<MindMapData>());
@@ -349,17 +470,42 @@ size_t Mediator::nodeCount() const
 }
 
 bool Mediator::openMindMap(QString fileName)
+{
+    return loadMindMap([this, fileName] {
+        m_editorData->loadMindMapData(fileName);
+    });
+}
+
+bool Mediator::recoverMindMap(QString recoveryFileName, QString fileName)
+{
+    return loadMindMap([this, recoveryFileName, fileName] {
+        m_editorData->recoverMindMapData(recoveryFileName, fileName);
+    });
+}
+
+bool Mediator::loadMindMap(std::function<void()> loader)
 {
     assert(m_editorData);
 
     try {
+        cancelPopulatingScene();
         m_editorScene = std::make_unique<EditorScene>();
-        m_editorData->loadMindMapData(fileName);
+        loader();
         initializeView();
-        addExistingGraphToScene();
+        // Show the saved view right away and add the rest of a big mind map to the scene in the background
+        const auto viewRect = m_editorData->mindMapData()->viewRect();
+        const bool showSavedView = viewRect.isValid() && nodeCount() >= Constants::View::PARTIAL_LOAD_MIN_NODES;
+        if (showSavedView) {
+            m_editorView->zoomToFit(viewRect);
+            populateSceneViewportFirst(m_editorView->mapToScene(m_editorView->viewport()->rect()).boundingRect());
+        } else {
+            addExistingGraphToScene();
+        }
         connectGraphToUndoMechanism();
         connectGraphToImageManager();
-        zoomToFit();
+        if (!showSavedView) {
+            zoomToFit();
+        }
     } catch (const FileException & e) {
         m_mainWindow.showErrorDialog(e.message());
         return false;
@@ -373,12 +519,12 @@ bool Mediator::openMindMap(QString fileName)
 
 void Mediator::redo()
 {
-    L().debug() << "Undo..";
+    L().debug() << "Redo..";
 
+    finishPopulatingScene();
     m_editorView->resetDummyDragItems();
-    m_editorData->redo();
 
-    setupMindMapAfterUndoOrRedo();
+    setupMindMapAfterUndoOrRedo(m_editorData->redo());
 }
 
 void Mediator::removeItem(QGraphicsItem & item)
@@ -391,18 +537,26 @@ void Mediator::toggleNodeInSelectionGroup(Node & node)
     m_editorData->toggleNodeInSelectionGroup(node);
 }
 
-bool Mediator::saveMindMapAs(QString fileName)
+void Mediator::saveMindMapAs(QString fileName)
 {
-    return m_editorData->saveMindMapAs(fileName);
+    storeViewRect();
+    m_editorData->saveMindMapAsAsync(fileName);
 }
 
-bool Mediator::saveMindMap()
+void Mediator::saveMindMap()
 {
-    return m_editorData->saveMindMap();
+    storeViewRect();
+    m_editorData->saveMindMapAsync();
+}
+
+void Mediator::storeViewRect()
+{
+    m_editorData->mindMapData()->setViewRect(m_editorView->mapToScene(m_editorView->viewport()->rect()).boundingRect());
 }
 
 void Mediator::saveUndoPoint()
 {
+    finishPopulatingScene();
     m_editorData->saveUndoPoint();
 }
 
@@ -498,11 +652,8 @@ void Mediator::setRectagleSelection(QRectF rect)
 {
     clearSelectionGroup();
 
-    const auto items = m_editorScene->items(rect, Qt::ContainsItemShape);
-    for (auto && item : items) {
-        if (const auto node = dynamic_cast<Node *>(item)) {
-            toggleNodeInSelectionGroup(*node);
-        }
+    for (auto && node : m_editorData->mindMapData()->graph().spatialIndex().contained(rect)) {
+        toggleNodeInSelectionGroup(*node);
     }
 }
 
@@ -535,32 +686,37 @@ void Mediator::setTextSize(int textSize)
     }
 }
 
-void Mediator::setupMindMapAfterUndoOrRedo()
+void Mediator::setupMindMapAfterUndoOrRedo(const UndoCommand::Result & result)
 {
-    const auto oldSceneRect = m_editorScene->sceneRect();
-    const auto oldCenter = m_editorView->mapToScene(m_editorView->viewport()->rect()).boundingRect().center();
-
-    m_editorScene = std::make_unique<EditorScene>();
-    m_editorView->setScene(m_editorScene.get());
-    m_editorView->setBackgroundBrush(QBrush(m_editorData->backgroundColor()));
+    // Undo and redo change the mind map in place, so the scene, its index and the view are kept
+    for (auto && node : result.addedNodes) {
+        connectNodeToUndoMechanism(node);
+        connectNodeToImageManager(node);
+        addNodeToScene(*node);
+    }
 
-    addExistingGraphToScene();
+    for (auto && edge : result.addedEdges) {
+        connectEdgeToUndoMechanism(edge);
+        addEdgeToScene(*edge);
+    }
 
-    connectGraphToUndoMechanism();
-    connectGraphToImageManager();
+    if (result.designChanged) {
+        m_editorView->setBackgroundBrush(QBrush(m_editorData->backgroundColor()));
+        updateWidgetsFromMindMapData();
+        m_editorScene->update();
+    }
 
-    m_editorScene->setSceneRect(oldSceneRect);
-    m_editorView->centerOn(oldCenter);
+    L().debug() << "Added " << result.addedNodes.size() << " nodes and " << result.addedEdges.size() << " edges to scene";
 }
 
 void Mediator::undo()
 {
     L().debug() << "Undo..";
 
+    finishPopulatingScene();
     m_editorView->resetDummyDragItems();
-    m_editorData->undo();
 
-    setupMindMapAfterUndoOrRedo();
+    setupMindMapAfterUndoOrRedo(m_editorData->undo());
 }
 
 static const int zoomSensitivity = 20;
@@ -577,16 +733,18 @@ void Mediator::zoomOut()
 
 QSize Mediator::zoomForExport()
 {
+    finishPopulatingScene();
     clearSelectedNode();
     clearSelectionGroup();
-    m_editorScene->setSceneRect(m_editorScene->zoomToFit(true));
+    m_editorScene->setSceneRect(MagicZoom::calculateRectangle(m_editorData->mindMapData()->graph().spatialIndex(), true));
     return m_editorScene->sceneRect().size().toSize();
 }
 
 void Mediator::zoomToFit()
 {
+    // The nodes still being added to the scene are already in the spatial index
     if (hasNodes()) {
-        m_editorView->zoomToFit(m_editorScene->zoomToFit());
+        m_editorView->zoomToFit(MagicZoom::calculateRectangle(m_editorData->mindMapData()->graph().spatialIndex(), false));
     }
 }
 
@@ -620,9 +778,10 @@ void Mediator::clearSelectedNode()
 
 NodePtr Mediator::getBestOverlapNode(const Node & source)
 {
-    NodePtr bestNode;
+    Node * bestNode = nullptr;
     double bestScore = 0;
-    for (auto && node : m_editorData->mindMapData()->graph().getNodes()) {
+    auto && graph = m_editorData->mindMapData()->graph();
+    for (auto && node : graph.spatialIndex().intersecting(source.boundingRect().translated(source.pos()))) {
         if (node->index() != source.index() && node->index() != mouseAction().sourceNode()->index() && !areDirectlyConnected(*node, *mouseAction().sourceNode())) {
             const auto score = calculateNodeOverlapScore(source, *node);
             if (score > 0.75 && score > bestScore) {
@@ -632,7 +791,7 @@ NodePtr Mediator::getBestOverlapNode(const Node & source)
         }
     }
 
-    return bestNode;
+    return bestNode ? graph.getNode(bestNode->index()) : nullptr;
 }
 
 Mediator::~Mediator() = default;
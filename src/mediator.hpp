@@ -18,10 +18,17 @@
 
 #include <QObject>
 #include <QPointF>
+#include <QRectF>
 #include <QString>
+#include <QTimer>
+
+#include <functional>
+#include <utility>
+#include <vector>
 
 #include "mind_map_data.hpp"
 #include "node.hpp"
+#include "undo_command.hpp"
 
 class MouseAction;
 class EditorData;
@@ -109,13 +116,16 @@ public:
 
     bool openMindMap(QString fileName);
 
+    bool recoverMindMap(QString recoveryFileName, QString fileName);
+
     void redo();
 
     void removeItem(QGraphicsItem & item);
 
-    bool saveMindMapAs(QString fileName);
+    //! Saving happens in the background, see EditorData::saveFinished().
+    void saveMindMapAs(QString fileName);
 
-    bool saveMindMap();
+    void saveMindMap();
 
     QSize sceneRectSize() const;
 
@@ -169,6 +179,8 @@ public slots:
 
 private slots:
 
+    void populateSceneBatch();
+
     void zoomIn();
 
     void zoomOut();
@@ -180,15 +192,40 @@ signals:
     void svgExportFinished(bool success);
 
 private:
+    //! Adds every node and edge that is not in the scene yet. Single new items are added with
+    //! addNodeToScene() and addEdgeToScene() instead.
     void addExistingGraphToScene();
 
+    void addEdgeToScene(Edge & edge);
+
+    void addNodeToScene(Node & node);
+
     double calculateNodeOverlapScore(const Node & node1, const Node & node2) const;
 
+    void cancelPopulatingScene();
+
     void connectGraphToUndoMechanism();
 
     void connectGraphToImageManager();
 
-    void setupMindMapAfterUndoOrRedo();
+    //! Adds the rest of a scene that is being populated in the background right away.
+    void finishPopulatingScene();
+
+    bool isPopulatingScene() const;
+
+    bool loadMindMap(std::function<void()> loader);
+
+    //! Adds the nodes in the view to the scene right away and the rest nearest first in batches.
+    void populateSceneViewportFirst(QRectF viewRect);
+
+    void populateScene(size_t nodeCount);
+
+    //! Adds the created nodes and edges to the live scene. Changed and deleted ones are already up-to-date.
+    void setupMindMapAfterUndoOrRedo(const UndoCommand::Result & result);
+
+    void storeViewRect();
+
+    void updateWidgetsFromMindMapData();
 
     std::shared_ptr<EditorData> m_editorData;
 
@@ -197,6 +234,17 @@ private:
     EditorView * m_editorView = nullptr;
 
     MainWindow & m_mainWindow;
+
+    QTimer m_populateTimer;
+
+    std::vector<NodePtr> m_pendingNodes;
+
+    // Each edge with the rank of the later of its nodes in m_pendingNodes
+    std::vector<std::pair<size_t, EdgePtr>> m_pendingEdges;
+
+    size_t m_populatedNodeCount = 0;
+
+    size_t m_populatedEdgeCount = 0;
 };
 
 #endif // MEDIATOR_HPP
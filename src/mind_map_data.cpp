@@ -36,6 +36,10 @@ MindMapData::MindMapData(const MindMapData & other)
   , m_edgeWidth(other.m_edgeWidth)
   , m_textSize(other.m_textSize)
   , m_cornerRadius(other.m_cornerRadius)
+  , m_aspectRatio(other.m_aspectRatio)
+  , m_minEdgeLength(other.m_minEdgeLength)
+  , m_imageImportOptions(other.m_imageImportOptions)
+  , m_viewRect(other.m_viewRect)
 {
     copyGraph(other);
 }
@@ -163,6 +167,16 @@ const ImageManager & MindMapData::imageManager() const
     return m_imageManager;
 }
 
+ImageImportOptions MindMapData::imageImportOptions() const
+{
+    return m_imageImportOptions;
+}
+
+void MindMapData::setImageImportOptions(ImageImportOptions imageImportOptions)
+{
+    m_imageImportOptions = imageImportOptions;
+}
+
 double MindMapData::minEdgeLength() const
 {
     return m_minEdgeLength;
@@ -201,4 +215,14 @@ void MindMapData::setVersion(const QString & version)
     m_version = version;
 }
 
+QRectF MindMapData::viewRect() const
+{
+    return m_viewRect;
+}
+
+void MindMapData::setViewRect(QRectF viewRect)
+{
+    m_viewRect = viewRect;
+}
+
 MindMapData::~MindMapData() = default;
@@ -16,10 +16,12 @@
 #ifndef MIND_MAP_DATA_HPP
 #define MIND_MAP_DATA_HPP
 
+#include <QRectF>
 #include <QString>
 
 #include "constants.hpp"
 #include "graph.hpp"
+#include "image_import_options.hpp"
 #include "image_manager.hpp"
 #include "mind_map_data_base.hpp"
 
@@ -66,6 +68,11 @@ public:
 
     const Graph & graph() const;
 
+    //! Import settings are stored per mind map so that batch imports stay consistent.
+    ImageImportOptions imageImportOptions() const;
+
+    void setImageImportOptions(ImageImportOptions imageImportOptions);
+
     double minEdgeLength() const;
 
     void setMinEdgeLength(double minEdgeLength);
@@ -78,6 +85,11 @@ public:
 
     void setVersion(const QString & version);
 
+    //! The visible scene rect when the mind map was saved. Invalid if not known.
+    QRectF viewRect() const;
+
+    void setViewRect(QRectF viewRect);
+
     ImageManager & imageManager();
 
     const ImageManager & imageManager() const;
@@ -105,6 +117,10 @@ private:
 
     double m_minEdgeLength = Constants::LayoutOptimizer::DEFAULT_MIN_EDGE_LENGTH;
 
+    ImageImportOptions m_imageImportOptions;
+
+    QRectF m_viewRect;
+
     Graph m_graph;
 
     static ImageManager m_imageManager;
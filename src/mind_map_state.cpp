@@ -0,0 +1,106 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "mind_map_state.hpp"
+
+#include "mind_map_data.hpp"
+#include "node.hpp"
+
+#include <algorithm>
+#include <utility>
+
+using NodeState = MindMapState::NodeState;
+using EdgeState = MindMapState::EdgeState;
+
+bool operator==(const NodeState & lhs, const NodeState & rhs)
+{
+    return lhs.index == rhs.index && lhs.location == rhs.location && lhs.size == rhs.size && lhs.text == rhs.text
+      && lhs.color == rhs.color && lhs.textColor == rhs.textColor && lhs.imageRef == rhs.imageRef;
+}
+
+bool operator==(const EdgeState & lhs, const EdgeState & rhs)
+{
+    return lhs.index0 == rhs.index0 && lhs.index1 == rhs.index1 && lhs.arrowMode == rhs.arrowMode && lhs.reversed == rhs.reversed && lhs.text == rhs.text;
+}
+
+static int key(const NodeState & node)
+{
+    return node.index;
+}
+
+static std::pair<int, int> key(const EdgeState & edge)
+{
+    return { edge.index0, edge.index1 };
+}
+
+MindMapState MindMapState::capture(const MindMapData & mindMapData)
+{
+    MindMapState state;
+
+    state.design.backgroundColor = mindMapData.backgroundColor();
+    state.design.edgeColor = mindMapData.edgeColor();
+    state.design.gridColor = mindMapData.gridColor();
+    state.design.edgeWidth = mindMapData.edgeWidth();
+    state.design.textSize = mindMapData.textSize();
+    state.design.cornerRadius = mindMapData.cornerRadius();
+    state.design.aspectRatio = mindMapData.aspectRatio();
+    state.design.minEdgeLength = mindMapData.minEdgeLength();
+    state.design.imageImportOptions = mindMapData.imageImportOptions();
+
+    state.nodes.reserve(mindMapData.graph().getNodes().size());
+    for (auto && node : mindMapData.graph().getNodes()) {
+        state.nodes.push_back({ node->index(), node->location(), node->size(), node->text(), node->color(), node->textColor(), node->imageRef() });
+    }
+    std::sort(state.nodes.begin(), state.nodes.end(), [](const NodeState & lhs, const NodeState & rhs) {
+        return key(lhs) < key(rhs);
+    });
+
+    state.edges.reserve(mindMapData.graph().getEdges().size());
+    for (auto && edge : mindMapData.graph().getEdges()) {
+        state.edges.push_back({ edge->sourceNode().index(), edge->targetNode().index(), edge->arrowMode(), edge->reversed(), edge->text() });
+    }
+    std::sort(state.edges.begin(), state.edges.end(), [](const EdgeState & lhs, const EdgeState & rhs) {
+        return key(lhs) < key(rhs);
+    });
+
+    return state;
+}
+
+MindMapState MindMapState::captureForSaving(const MindMapData & mindMapData)
+{
+    auto state = capture(mindMapData);
+    state.viewRect = mindMapData.viewRect();
+    for (auto && node : state.nodes) {
+        if (node.imageRef && !state.images.count(node.imageRef)) {
+            const auto image = mindMapData.imageManager().getImage(node.imageRef);
+            if (image.second) {
+                state.images[node.imageRef] = image.first;
+            }
+        }
+    }
+    return state;
+}
+
+size_t MindMapState::byteSize() const
+{
+    size_t size = sizeof(*this) + nodes.capacity() * sizeof(NodeState) + edges.capacity() * sizeof(EdgeState);
+    for (auto && node : nodes) {
+        size += static_cast<size_t>(node.text.capacity()) * sizeof(QChar);
+    }
+    for (auto && edge : edges) {
+        size += static_cast<size_t>(edge.text.capacity()) * sizeof(QChar);
+    }
+    return size;
+}
@@ -0,0 +1,116 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIND_MAP_STATE_HPP
+#define MIND_MAP_STATE_HPP
+
+#include "edge.hpp"
+#include "image.hpp"
+#include "image_import_options.hpp"
+
+#include <QColor>
+#include <QPointF>
+#include <QRectF>
+#include <QSizeF>
+#include <QString>
+
+#include <map>
+#include <vector>
+
+class MindMapData;
+
+//! Plain-data copy of everything in a mind map that can be undone. Unlike a copy of
+//! MindMapData it doesn't create any graphics items, so it can also be written on a worker thread.
+struct MindMapState
+{
+    struct Design
+    {
+        QColor backgroundColor;
+
+        QColor edgeColor;
+
+        QColor gridColor;
+
+        double edgeWidth = 0;
+
+        int textSize = 0;
+
+        int cornerRadius = 0;
+
+        double aspectRatio = 0;
+
+        double minEdgeLength = 0;
+
+        ImageImportOptions imageImportOptions;
+    };
+
+    struct NodeState
+    {
+        int index = -1;
+
+        QPointF location;
+
+        QSizeF size;
+
+        QString text;
+
+        QColor color;
+
+        QColor textColor;
+
+        size_t imageRef = 0;
+    };
+
+    struct EdgeState
+    {
+        int index0 = -1;
+
+        int index1 = -1;
+
+        Edge::ArrowMode arrowMode = Edge::ArrowMode::Single;
+
+        bool reversed = false;
+
+        QString text;
+    };
+
+    static MindMapState capture(const MindMapData & mindMapData);
+
+    //! Captures also the view and the images so that the state can be saved as a whole.
+    static MindMapState captureForSaving(const MindMapData & mindMapData);
+
+    //! Approximate memory use in bytes.
+    size_t byteSize() const;
+
+    Design design;
+
+    //! Sorted by index.
+    std::vector<NodeState> nodes;
+
+    //! Sorted by (index0, index1).
+    std::vector<EdgeState> edges;
+
+    //! Only captured for saving.
+    QRectF viewRect;
+
+    //! The canonical images by the image refs of the nodes. Only captured for saving.
+    std::map<size_t, Image> images;
+};
+
+bool operator==(const MindMapState::NodeState & lhs, const MindMapState::NodeState & rhs);
+
+bool operator==(const MindMapState::EdgeState & lhs, const MindMapState::EdgeState & rhs);
+
+#endif // MIND_MAP_STATE_HPP
@@ -17,18 +17,20 @@
 
 #include "constants.hpp"
 #include "edge.hpp"
+#include "edge_update_scheduler.hpp"
 #include "graphics_factory.hpp"
-#include "image.hpp"
+#include "image_cache.hpp"
 #include "layers.hpp"
 #include "node_handle.hpp"
+#include "spatial_index.hpp"
 #include "test_mode.hpp"
 #include "text_edit.hpp"
 
 #include "simple_logger.hpp"
 
 #include <QGraphicsSceneHoverEvent>
-#include <QImage>
 #include <QPainter>
+#include <QStyleOptionGraphicsItem>
 #include <QPen>
 #include <QVector2D>
 
@@ -126,18 +128,50 @@ void Node::adjustSize()
     };
 
     m_size = newSize;
+    m_isLayoutPending = false;
 
-    createHandles();
-
-    createEdgePoints();
+    createGeometry();
 
     updateEdgeLines();
 
-    initTextField();
+    updateSpatialIndex();
 
     update();
 }
 
+void Node::applyDesign(int cornerRadius, int textSize)
+{
+    m_cornerRadius = cornerRadius;
+
+    if (m_textSize != textSize) {
+        m_textSize = textSize;
+        if (!TestMode::enabled()) {
+            m_textEdit->setTextSize(textSize);
+        } else {
+            TestMode::logDisabledCode("set widget text size");
+        }
+        // A known size was laid out with the text size of the mind map
+        if (!m_isLayoutPending) {
+            adjustSize();
+            return;
+        }
+    }
+
+    if (m_isLayoutPending) {
+        m_isLayoutPending = false;
+        createGeometry();
+    }
+}
+
+void Node::createGeometry()
+{
+    createHandles();
+
+    createEdgePoints();
+
+    initTextField();
+}
+
 QRectF Node::boundingRect() const
 {
     // Take children into account
@@ -326,7 +360,6 @@ void Node::initTextField()
 void Node::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget)
 {
     Q_UNUSED(widget)
-    Q_UNUSED(option)
 
     painter->save();
 
@@ -337,7 +370,10 @@ void Node::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QW
     path.addRoundedRect(rect, m_cornerRadius, m_cornerRadius);
     painter->setRenderHint(QPainter::Antialiasing);
 
-    if (!m_pixmap.isNull()) {
+    // Request the image at the resolution it is actually shown at, so that zoomed-out views never decode full size
+    const auto levelOfDetail = std::min(1.0, option->levelOfDetailFromTransform(painter->worldTransform()));
+    const auto pixmap = m_imageRef ? ImageCache::instance().pixmap(m_image, (m_size * levelOfDetail).toSize().expandedTo({ 1, 1 })) : QPixmap {};
+    if (!pixmap.isNull()) {
         QPixmap scaledPixmap(static_cast<int>(m_size.width()), static_cast<int>(m_size.height()));
         scaledPixmap.fill(Qt::transparent);
         QPainter pixmapPainter(&scaledPixmap);
@@ -345,19 +381,19 @@ void Node::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QW
         const QRectF scaledRect(0, 0, m_size.width(), m_size.height());
         scaledPath.addRoundedRect(scaledRect, m_cornerRadius, m_cornerRadius);
 
-        const auto pixmapAspect = static_cast<double>(m_pixmap.width()) / m_pixmap.height();
+        const auto pixmapAspect = static_cast<double>(pixmap.width()) / pixmap.height();
         const auto nodeAspect = m_size.width() / m_size.height();
         if (nodeAspect > 1.0) {
             if (pixmapAspect > nodeAspect) {
-                pixmapPainter.fillPath(scaledPath, QBrush(m_pixmap.scaledToHeight(static_cast<int>(m_size.height()))));
+                pixmapPainter.fillPath(scaledPath, QBrush(pixmap.scaledToHeight(static_cast<int>(m_size.height()))));
             } else {
-                pixmapPainter.fillPath(scaledPath, QBrush(m_pixmap.scaledToWidth(static_cast<int>(m_size.width()))));
+                pixmapPainter.fillPath(scaledPath, QBrush(pixmap.scaledToWidth(static_cast<int>(m_size.width()))));
             }
         } else {
             if (pixmapAspect < nodeAspect) {
-                pixmapPainter.fillPath(scaledPath, QBrush(m_pixmap.scaledToWidth(static_cast<int>(m_size.width()))));
+                pixmapPainter.fillPath(scaledPath, QBrush(pixmap.scaledToWidth(static_cast<int>(m_size.width()))));
             } else {
-                pixmapPainter.fillPath(scaledPath, QBrush(m_pixmap.scaledToHeight(static_cast<int>(m_size.height()))));
+                pixmapPainter.fillPath(scaledPath, QBrush(pixmap.scaledToHeight(static_cast<int>(m_size.height()))));
             }
         }
 
@@ -434,11 +470,32 @@ void Node::setLocation(QPointF newLocation)
     m_location = newLocation;
     setPos(newLocation);
 
+    updateSpatialIndex();
+
     updateEdgeLines();
 
     setHandlesVisible(false);
 }
 
+void Node::moveWith(QPointF delta, const std::set<Node *> & movedNodes)
+{
+    m_location += delta;
+    setPos(m_location);
+
+    updateSpatialIndex();
+
+    for (auto && edge : m_graphicsEdges) {
+        const bool isSource = &edge->sourceNode() == this;
+        if (!movedNodes.count(isSource ? &edge->targetNode() : &edge->sourceNode())) {
+            EdgeUpdateScheduler::instance().schedule(*edge);
+        } else if (isSource) {
+            edge->translate(delta);
+        }
+    }
+
+    setHandlesVisible(false);
+}
+
 QRectF Node::placementBoundingRect() const
 {
     return { -m_size.width() / 2, -m_size.height() / 2, m_size.width(), m_size.height() };
@@ -481,6 +538,21 @@ void Node::setText(const QString & text)
     }
 }
 
+void Node::setTextAndSize(const QString & text, const QSizeF & size)
+{
+    if (size.isEmpty()) {
+        setText(text);
+        return;
+    }
+
+    m_text = text;
+    m_textEdit->setText(text);
+    m_size = size;
+    m_isLayoutPending = true;
+
+    updateSpatialIndex();
+}
+
 QColor Node::textColor() const
 {
     return m_textColor;
@@ -502,7 +574,9 @@ void Node::setTextSize(int textSize)
     m_textSize = textSize;
     if (!TestMode::enabled()) {
         m_textEdit->setTextSize(textSize);
-        adjustSize();
+        if (!m_isLayoutPending) {
+            adjustSize();
+        }
     } else {
         TestMode::logDisabledCode("set widget text size");
     }
@@ -521,15 +595,16 @@ void Node::setImageRef(size_t imageRef)
 
 void Node::applyImage(const Image & image)
 {
-    m_pixmap = QPixmap::fromImage(image.image());
+    m_image = image;
 
     update();
 }
 
+// Edges shared by nodes that change at the same time, e.g. when moving a selection, are updated only once
 void Node::updateEdgeLines()
 {
     for (auto && edge : m_graphicsEdges) {
-        edge->updateLine();
+        EdgeUpdateScheduler::instance().schedule(*edge);
     }
 }
 
@@ -541,6 +616,8 @@ QSizeF Node::size() const
 void Node::setSize(const QSizeF & size)
 {
     m_size = size;
+
+    updateSpatialIndex();
 }
 
 size_t Node::imageRef() const
@@ -563,7 +640,23 @@ void Node::setIndex(int index)
     m_index = index;
 }
 
+void Node::setSpatialIndex(SpatialIndex * spatialIndex)
+{
+    m_spatialIndex = spatialIndex;
+}
+
+void Node::updateSpatialIndex()
+{
+    if (m_spatialIndex) {
+        m_spatialIndex->update(*this);
+    }
+}
+
 Node::~Node()
 {
+    if (m_spatialIndex) {
+        m_spatialIndex->remove(*this);
+    }
+
     juzzlin::L().debug() << "Deleting Node " << index();
 }
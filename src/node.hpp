@@ -17,19 +17,20 @@
 #define NODE_HPP
 
 #include <QGraphicsItem>
-#include <QImage>
 #include <QObject>
 #include <QTimer>
 
 #include <map>
+#include <set>
 #include <vector>
 
 #include "edge.hpp"
 #include "edge_point.hpp"
+#include "image.hpp"
 
-class Image;
 class NodeHandle;
 class QGraphicsTextItem;
+class SpatialIndex;
 class TextEdit;
 
 //! Freely placeable target node.
@@ -54,6 +55,10 @@ public:
 
     void adjustSize();
 
+    //! Applies the design of the mind map to a node that is not in the scene yet. Unlike the single
+    //! setters, this doesn't update edges, and the text is laid out only if the size is not known.
+    void applyDesign(int cornerRadius, int textSize);
+
     QRectF boundingRect() const override;
 
     using NodePtr = std::shared_ptr<Node>;
@@ -64,6 +69,10 @@ public:
     //! Sets the Node and QGraphicsItem locations.
     void setLocation(QPointF newLocation);
 
+    //! Moves the node as a part of movedNodes. Edges between moved nodes are moved as they are
+    //! and only edges to the nodes that stay are recalculated.
+    void moveWith(QPointF delta, const std::set<Node *> & movedNodes);
+
     QRectF placementBoundingRect() const;
 
     void hoverEnterEvent(QGraphicsSceneHoverEvent * event) override;
@@ -106,6 +115,10 @@ public:
 
     void setText(const QString & text);
 
+    //! Sets the text and the size it was laid out with, e.g. when loading a mind map, without laying
+    //! out the text again. The handles and edge points are created by applyDesign().
+    void setTextAndSize(const QString & text, const QSizeF & size);
+
     QColor textColor() const;
 
     void setTextColor(const QColor & color);
@@ -118,6 +131,9 @@ public:
 
     void applyImage(const Image & image);
 
+    //! Set by the spatial index the node is in, so that moves and resizes get updated to it.
+    void setSpatialIndex(SpatialIndex * spatialIndex);
+
 signals:
 
     void undoPointRequested();
@@ -131,6 +147,9 @@ private:
 
     void createHandles();
 
+    //! Creates everything that depends on the size.
+    void createGeometry();
+
     QRectF expandedTextEditRect() const;
 
     NodeHandle * hitsHandle(QPointF pos);
@@ -139,6 +158,8 @@ private:
 
     void updateEdgeLines();
 
+    void updateSpatialIndex();
+
     QColor m_color = Qt::white;
 
     int m_cornerRadius = 0;
@@ -151,6 +172,9 @@ private:
 
     QSizeF m_size;
 
+    //! The size is trusted and the geometry depending on it is not created yet.
+    bool m_isLayoutPending = false;
+
     QString m_text;
 
     bool m_selected = false;
@@ -165,6 +189,8 @@ private:
 
     std::vector<EdgePoint> m_edgePoints;
 
+    SpatialIndex * m_spatialIndex = nullptr;
+
     TextEdit * m_textEdit;
 
     QTimer m_handleVisibilityTimer;
@@ -173,7 +199,8 @@ private:
 
     bool m_mouseIn = false;
 
-    QPixmap m_pixmap;
+    //! Kept encoded, decoded pixmaps come from ImageCache when painting
+    Image m_image;
 };
 
 using NodePtr = std::shared_ptr<Node>;
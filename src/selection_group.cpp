@@ -17,8 +17,6 @@
 
 #include "node.hpp"
 
-#include <map>
-
 void SelectionGroup::clear()
 {
     for (auto && node : m_nodes) {
@@ -36,19 +34,15 @@ bool SelectionGroup::hasNode(Node & node) const
 
 void SelectionGroup::move(Node & reference, QPointF location)
 {
-    std::map<int, QPointF> delta;
-    for (auto && node : m_nodes) {
-        if (node->index() != reference.index()) {
-            delta[node->index()] = node->location() - reference.location();
-        }
-    }
+    const auto delta = location - reference.location();
 
-    reference.setLocation(location);
+    // The reference node is moved even if it's not in the group
+    if (!m_nodes.count(&reference)) {
+        reference.setLocation(location);
+    }
 
     for (auto && node : m_nodes) {
-        if (node->index() != reference.index()) {
-            node->setLocation(reference.location() + delta[node->index()]);
-        }
+        node->moveWith(delta, m_nodes);
     }
 }
 
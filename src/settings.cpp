@@ -26,11 +26,16 @@ namespace {
 const auto settingsGroupApplication = "Application";
 const auto settingsGroupDefaults = "Defaults";
 const auto settingsGroupMainWindow = "MainWindow";
+const auto autosaveIntervalSecKey = "autosaveIntervalSec";
 const auto recentImagePathKey = "recentImagePath";
 const auto edgeArrowModeKey = "edgeArrowMode";
 const auto gridSizeKey = "gridSize";
 const auto gridVisibleStateKey = "gridVisibleState";
+const auto imageCacheSizeMbKey = "imageCacheSizeMb";
+const auto incrementalSaveKey = "incrementalSave";
+const auto persistUndoHistoryKey = "persistUndoHistory";
 const auto recentPathKey = "recentPath";
+const auto recoveryFileNameKey = "recoveryFileName";
 const auto windowFullScreenKey = "fullScreen";
 const auto windowSizeKey = "size";
 } // namespace
@@ -167,3 +172,94 @@ void Settings::saveFullScreen(bool fullScreen)
     settings.setValue(windowFullScreenKey, fullScreen);
     settings.endGroup();
 }
+
+int Settings::loadImageCacheSizeMb()
+{
+    QSettings settings;
+    settings.beginGroup(settingsGroupApplication);
+    const auto sizeMb = settings.value(imageCacheSizeMbKey, Constants::ImageCache::DEFAULT_SIZE_MB).toInt();
+    settings.endGroup();
+    return sizeMb;
+}
+
+void Settings::saveImageCacheSizeMb(int sizeMb)
+{
+    QSettings settings;
+    settings.beginGroup(settingsGroupApplication);
+    settings.setValue(imageCacheSizeMbKey, sizeMb);
+    settings.endGroup();
+}
+
+int Settings::loadAutosaveIntervalSec()
+{
+    QSettings settings;
+    settings.beginGroup(settingsGroupApplication);
+    const auto intervalSec = settings.value(autosaveIntervalSecKey, Constants::Autosave::DEFAULT_INTERVAL_SEC).toInt();
+    settings.endGroup();
+    return intervalSec;
+}
+
+void Settings::saveAutosaveIntervalSec(int intervalSec)
+{
+    QSettings settings;
+    settings.beginGroup(settingsGroupApplication);
+    settings.setValue(autosaveIntervalSecKey, intervalSec);
+    settings.endGroup();
+}
+
+bool Settings::loadIncrementalSave()
+{
+    QSettings settings;
+    settings.beginGroup(settingsGroupApplication);
+    const auto incrementalSave = settings.value(incrementalSaveKey, false).toBool();
+    settings.endGroup();
+    return incrementalSave;
+}
+
+void Settings::saveIncrementalSave(bool incrementalSave)
+{
+    QSettings settings;
+    settings.beginGroup(settingsGroupApplication);
+    settings.setValue(incrementalSaveKey, incrementalSave);
+    settings.endGroup();
+}
+
+bool Settings::loadPersistUndoHistory()
+{
+    QSettings settings;
+    settings.beginGroup(settingsGroupApplication);
+    const auto persistUndoHistory = settings.value(persistUndoHistoryKey, false).toBool();
+    settings.endGroup();
+    return persistUndoHistory;
+}
+
+void Settings::savePersistUndoHistory(bool persistUndoHistory)
+{
+    QSettings settings;
+    settings.beginGroup(settingsGroupApplication);
+    settings.setValue(persistUndoHistoryKey, persistUndoHistory);
+    settings.endGroup();
+}
+
+// Keys of the numbered recovery files are numbered as well
+static QString recoveryFileNameKeyForSlot(int slot)
+{
+    return slot ? QString(recoveryFileNameKey) + QString::number(slot) : recoveryFileNameKey;
+}
+
+QString Settings::loadRecoveryFileName(int slot)
+{
+    QSettings settings;
+    settings.beginGroup(settingsGroupApplication);
+    const auto fileName = settings.value(recoveryFileNameKeyForSlot(slot), "").toString();
+    settings.endGroup();
+    return fileName;
+}
+
+void Settings::saveRecoveryFileName(int slot, QString fileName)
+{
+    QSettings settings;
+    settings.beginGroup(settingsGroupApplication);
+    settings.setValue(recoveryFileNameKeyForSlot(slot), fileName);
+    settings.endGroup();
+}
@@ -50,6 +50,27 @@ bool loadFullScreen();
 
 void saveFullScreen(bool fullScreen);
 
+int loadImageCacheSizeMb();
+
+void saveImageCacheSizeMb(int sizeMb);
+
+int loadAutosaveIntervalSec();
+
+void saveAutosaveIntervalSec(int intervalSec);
+
+bool loadIncrementalSave();
+
+void saveIncrementalSave(bool incrementalSave);
+
+bool loadPersistUndoHistory();
+
+void savePersistUndoHistory(bool persistUndoHistory);
+
+//! Name of the file the autosaved mind map of the given recovery file belongs to, empty if it was never saved.
+QString loadRecoveryFileName(int slot);
+
+void saveRecoveryFileName(int slot, QString fileName);
+
 } // namespace Settings
 
 #endif // SETTINGS_HPP
@@ -0,0 +1,398 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "spatial_index.hpp"
+
+#include "node.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+// Cells are not split below this half size
+static const double MIN_HALF_SIZE = 16;
+
+struct SpatialIndex::Cell
+{
+    Cell(QPointF center, double halfSize, Cell * parent)
+      : center(center)
+      , halfSize(halfSize)
+      , parent(parent)
+    {
+    }
+
+    struct Item
+    {
+        Node * node;
+
+        QRectF rect;
+    };
+
+    //! Area in which the items of the cell may be.
+    QRectF looseRect() const
+    {
+        return { center.x() - 2 * halfSize, center.y() - 2 * halfSize, 4 * halfSize, 4 * halfSize };
+    }
+
+    bool fits(const QRectF & rect) const
+    {
+        const auto delta = rect.center() - center;
+        return std::abs(delta.x()) <= halfSize && std::abs(delta.y()) <= halfSize && std::max(rect.width(), rect.height()) <= 2 * halfSize;
+    }
+
+    //! \return true if the rect should go to a child cell.
+    bool fitsChild(const QRectF & rect) const
+    {
+        return halfSize / 2 >= MIN_HALF_SIZE && std::max(rect.width(), rect.height()) <= halfSize;
+    }
+
+    size_t quadrant(QPointF pos) const
+    {
+        return (pos.x() >= center.x() ? 1 : 0) + (pos.y() >= center.y() ? 2 : 0);
+    }
+
+    QPointF childCenter(size_t quadrant) const
+    {
+        return center + QPointF { quadrant & 1 ? halfSize / 2 : -halfSize / 2, quadrant & 2 ? halfSize / 2 : -halfSize / 2 };
+    }
+
+    bool isEmpty() const
+    {
+        return items.empty() && std::none_of(children.begin(), children.end(), [](auto && child) {
+                   return static_cast<bool>(child);
+               });
+    }
+
+    QPointF center;
+
+    double halfSize;
+
+    Cell * parent;
+
+    std::array<std::unique_ptr<Cell>, 4> children;
+
+    std::vector<Item> items;
+};
+
+SpatialIndex::SpatialIndex()
+{
+    resetBounds();
+}
+
+SpatialIndex::~SpatialIndex()
+{
+    clear();
+}
+
+QRectF SpatialIndex::nodeRect(const Node & node)
+{
+    return node.placementBoundingRect().translated(node.location());
+}
+
+void SpatialIndex::insert(Node & node)
+{
+    if (m_cells.count(&node)) {
+        return;
+    }
+
+    node.setSpatialIndex(this);
+    const auto rect = nodeRect(node);
+    insert(node, rect);
+    addToBounds(rect);
+    m_nodeArea += rect.width() * rect.height();
+}
+
+void SpatialIndex::insert(Node & node, const QRectF & rect)
+{
+    if (!m_root) {
+        m_root = std::make_unique<Cell>(rect.center(), std::max({ rect.width() / 2, rect.height() / 2, MIN_HALF_SIZE }), nullptr);
+    }
+
+    while (!m_root->fits(rect)) {
+        grow(rect.center());
+    }
+
+    auto cell = m_root.get();
+    while (cell->fitsChild(rect)) {
+        const auto quadrant = cell->quadrant(rect.center());
+        auto && child = cell->children[quadrant];
+        if (!child) {
+            child = std::make_unique<Cell>(cell->childCenter(quadrant), cell->halfSize / 2, cell);
+        }
+        cell = child.get();
+    }
+
+    cell->items.push_back({ &node, rect });
+    m_cells[&node] = cell;
+}
+
+// Makes the root a quadrant of a new root twice as big, extending towards pos
+void SpatialIndex::grow(QPointF pos)
+{
+    auto oldRoot = std::move(m_root);
+    const auto halfSize = oldRoot->halfSize;
+    const QPointF center {
+        oldRoot->center.x() + (pos.x() >= oldRoot->center.x() ? halfSize : -halfSize),
+        oldRoot->center.y() + (pos.y() >= oldRoot->center.y() ? halfSize : -halfSize)
+    };
+    m_root = std::make_unique<Cell>(center, halfSize * 2, nullptr);
+    oldRoot->parent = m_root.get();
+    const auto quadrant = m_root->quadrant(oldRoot->center);
+    m_root->children[quadrant] = std::move(oldRoot);
+}
+
+void SpatialIndex::remove(Node & node)
+{
+    const auto iter = m_cells.find(&node);
+    if (iter == m_cells.end()) {
+        return;
+    }
+
+    const auto rect = erase(node, *iter->second);
+    node.setSpatialIndex(nullptr);
+    if (m_cells.empty()) {
+        clear();
+    } else {
+        removeFromBounds(rect);
+        m_nodeArea -= rect.width() * rect.height();
+    }
+}
+
+QRectF SpatialIndex::erase(Node & node, Cell & cell)
+{
+    m_cells.erase(&node);
+
+    auto && items = cell.items;
+    const auto iter = std::find_if(items.begin(), items.end(), [&node](auto && item) {
+        return item.node == &node;
+    });
+    const auto rect = iter->rect;
+    items.erase(iter);
+
+    // Drop the cells left empty
+    auto emptyCell = &cell;
+    while (emptyCell->parent && emptyCell->isEmpty()) {
+        const auto parent = emptyCell->parent;
+        parent->children[parent->quadrant(emptyCell->center)].reset();
+        emptyCell = parent;
+    }
+
+    if (m_cells.empty()) {
+        m_root.reset();
+    }
+
+    return rect;
+}
+
+void SpatialIndex::update(Node & node)
+{
+    const auto iter = m_cells.find(&node);
+    if (iter == m_cells.end()) {
+        return;
+    }
+
+    const auto rect = nodeRect(node);
+    const auto cell = iter->second;
+    QRectF oldRect;
+    if (cell->fits(rect) && !cell->fitsChild(rect)) {
+        for (auto && item : cell->items) {
+            if (item.node == &node) {
+                oldRect = item.rect;
+                item.rect = rect;
+                break;
+            }
+        }
+    } else {
+        oldRect = erase(node, *cell);
+        insert(node, rect);
+    }
+
+    removeFromBounds(oldRect, rect);
+    addToBounds(rect);
+    m_nodeArea += rect.width() * rect.height() - oldRect.width() * oldRect.height();
+}
+
+void SpatialIndex::clear()
+{
+    for (auto && nodeAndCell : m_cells) {
+        nodeAndCell.first->setSpatialIndex(nullptr);
+    }
+
+    m_cells.clear();
+    m_root.reset();
+    resetBounds();
+}
+
+size_t SpatialIndex::size() const
+{
+    return m_cells.size();
+}
+
+std::vector<Node *> SpatialIndex::query(const QRectF & rect, bool mustContain) const
+{
+    std::vector<Node *> result;
+    std::vector<const Cell *> cells;
+    if (m_root) {
+        cells.push_back(m_root.get());
+    }
+
+    while (!cells.empty()) {
+        const auto cell = cells.back();
+        cells.pop_back();
+        for (auto && item : cell->items) {
+            if (mustContain ? rect.contains(item.rect) : rect.intersects(item.rect)) {
+                result.push_back(item.node);
+            }
+        }
+        for (auto && child : cell->children) {
+            if (child && rect.intersects(child->looseRect())) {
+                cells.push_back(child.get());
+            }
+        }
+    }
+
+    return result;
+}
+
+std::vector<Node *> SpatialIndex::intersecting(const QRectF & rect) const
+{
+    return query(rect, false);
+}
+
+std::vector<Node *> SpatialIndex::contained(const QRectF & rect) const
+{
+    return query(rect, true);
+}
+
+static double squaredDistance(QPointF pos, const QRectF & rect)
+{
+    const auto dx = std::max({ rect.left() - pos.x(), 0.0, pos.x() - rect.right() });
+    const auto dy = std::max({ rect.top() - pos.y(), 0.0, pos.y() - rect.bottom() });
+    return dx * dx + dy * dy;
+}
+
+Node * SpatialIndex::nearest(QPointF pos) const
+{
+    if (!m_root) {
+        return nullptr;
+    }
+
+    // Best-first search: cells are visited in the order of their distance until none can be nearer
+    using CellDistance = std::pair<double, const Cell *>;
+    const auto isFarther = [](const CellDistance & lhs, const CellDistance & rhs) {
+        return lhs.first > rhs.first;
+    };
+    std::priority_queue<CellDistance, std::vector<CellDistance>, decltype(isFarther)> cells(isFarther);
+    cells.push({ squaredDistance(pos, m_root->looseRect()), m_root.get() });
+
+    Node * nearestNode = nullptr;
+    double nearestDistance = 0;
+    while (!cells.empty() && (!nearestNode || cells.top().first < nearestDistance)) {
+        const auto cell = cells.top().second;
+        cells.pop();
+        for (auto && item : cell->items) {
+            const auto distance = squaredDistance(pos, item.rect);
+            if (!nearestNode || distance < nearestDistance) {
+                nearestNode = item.node;
+                nearestDistance = distance;
+            }
+        }
+        for (auto && child : cell->children) {
+            if (child) {
+                cells.push({ squaredDistance(pos, child->looseRect()), child.get() });
+            }
+        }
+    }
+
+    return nearestNode;
+}
+
+QRectF SpatialIndex::bounds() const
+{
+    if (m_isBoundsDirty) {
+        recalculateBounds();
+    }
+
+    return m_left <= m_right ? QRectF { QPointF { m_left, m_top }, QPointF { m_right, m_bottom } } : QRectF {};
+}
+
+double SpatialIndex::nodeArea() const
+{
+    return m_nodeArea;
+}
+
+void SpatialIndex::addToBounds(const QRectF & rect)
+{
+    if (!m_isBoundsDirty) {
+        extendBounds(rect);
+    }
+}
+
+void SpatialIndex::extendBounds(const QRectF & rect) const
+{
+    m_left = std::min(m_left, rect.left());
+    m_top = std::min(m_top, rect.top());
+    m_right = std::max(m_right, rect.right());
+    m_bottom = std::max(m_bottom, rect.bottom());
+}
+
+void SpatialIndex::removeFromBounds(const QRectF & oldRect, const QRectF & newRect)
+{
+    if (m_isBoundsDirty) {
+        return;
+    }
+
+    const bool hasNewRect = !newRect.isNull();
+    m_isBoundsDirty = (oldRect.left() <= m_left && (!hasNewRect || newRect.left() > m_left))
+      || (oldRect.top() <= m_top && (!hasNewRect || newRect.top() > m_top))
+      || (oldRect.right() >= m_right && (!hasNewRect || newRect.right() < m_right))
+      || (oldRect.bottom() >= m_bottom && (!hasNewRect || newRect.bottom() < m_bottom));
+}
+
+// Also recalculates the area so that rounding errors of the updates don't accumulate
+void SpatialIndex::recalculateBounds() const
+{
+    resetBounds();
+    std::vector<const Cell *> cells;
+    if (m_root) {
+        cells.push_back(m_root.get());
+    }
+
+    while (!cells.empty()) {
+        const auto cell = cells.back();
+        cells.pop_back();
+        for (auto && item : cell->items) {
+            extendBounds(item.rect);
+            m_nodeArea += item.rect.width() * item.rect.height();
+        }
+        for (auto && child : cell->children) {
+            if (child) {
+                cells.push_back(child.get());
+            }
+        }
+    }
+
+    m_isBoundsDirty = false;
+}
+
+void SpatialIndex::resetBounds() const
+{
+    m_left = m_top = std::numeric_limits<double>::max();
+    m_right = m_bottom = std::numeric_limits<double>::lowest();
+    m_nodeArea = 0;
+    m_isBoundsDirty = false;
+}
@@ -0,0 +1,118 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SPATIAL_INDEX_HPP
+#define SPATIAL_INDEX_HPP
+
+#include <QPointF>
+#include <QRectF>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class Node;
+
+//! Loose quadtree of the placement rects of nodes. A node is stored in the smallest cell that
+//! contains its center and is at least as big as the node, so a cell's items may extend over
+//! its borders by half of its size. Nodes update the index themselves when moved or resized,
+//! and a node that stays in its cell, e.g. while dragged, is not reinserted.
+//!
+//! The bounds and the total area of the nodes are kept up-to-date as well. The bounds only grow
+//! on the fly and are recalculated on the next query after a node at the boundary moved inwards
+//! or was removed.
+class SpatialIndex
+{
+public:
+    SpatialIndex();
+
+    SpatialIndex(const SpatialIndex & other) = delete;
+
+    SpatialIndex & operator=(const SpatialIndex & other) = delete;
+
+    ~SpatialIndex();
+
+    void insert(Node & node);
+
+    void remove(Node & node);
+
+    //! Called by the node when its location or size has changed.
+    void update(Node & node);
+
+    void clear();
+
+    size_t size() const;
+
+    //! \return Nodes whose placement rect intersects the given rect.
+    std::vector<Node *> intersecting(const QRectF & rect) const;
+
+    //! \return Nodes whose placement rect is inside the given rect.
+    std::vector<Node *> contained(const QRectF & rect) const;
+
+    //! \return The node whose placement rect is the nearest to the given position or nullptr if empty.
+    Node * nearest(QPointF pos) const;
+
+    //! \return Bounding rect of the placement rects of all nodes or a null rect if empty.
+    QRectF bounds() const;
+
+    //! \return Sum of the areas of the placement rects of all nodes.
+    double nodeArea() const;
+
+    //! \return Placement rect of the node in scene coordinates.
+    static QRectF nodeRect(const Node & node);
+
+private:
+    struct Cell;
+
+    void insert(Node & node, const QRectF & rect);
+
+    //! Removes the node from its cell.
+    //! \return The rect of the node.
+    QRectF erase(Node & node, Cell & cell);
+
+    std::vector<Node *> query(const QRectF & rect, bool mustContain) const;
+
+    void grow(QPointF pos);
+
+    void addToBounds(const QRectF & rect);
+
+    void extendBounds(const QRectF & rect) const;
+
+    //! Marks the bounds to be recalculated if they depend on the old rect and not on the new one.
+    void removeFromBounds(const QRectF & oldRect, const QRectF & newRect = {});
+
+    void recalculateBounds() const;
+
+    void resetBounds() const;
+
+    std::unique_ptr<Cell> m_root;
+
+    std::unordered_map<Node *, Cell *> m_cells;
+
+    // The edges are kept separately so that they are exactly the edges of the node rects
+    mutable double m_left;
+
+    mutable double m_top;
+
+    mutable double m_right;
+
+    mutable double m_bottom;
+
+    mutable double m_nodeArea = 0;
+
+    mutable bool m_isBoundsDirty = false;
+};
+
+#endif // SPATIAL_INDEX_HPP
@@ -0,0 +1,380 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "undo_command.hpp"
+
+#include "mind_map_data.hpp"
+#include "node.hpp"
+
+#include <QDataStream>
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+using Design = MindMapState::Design;
+using NodeState = MindMapState::NodeState;
+using EdgeState = MindMapState::EdgeState;
+
+static bool operator==(const Design & lhs, const Design & rhs)
+{
+    return lhs.backgroundColor == rhs.backgroundColor && lhs.edgeColor == rhs.edgeColor && lhs.gridColor == rhs.gridColor
+      && qFuzzyCompare(lhs.edgeWidth, rhs.edgeWidth) && lhs.textSize == rhs.textSize && lhs.cornerRadius == rhs.cornerRadius
+      && qFuzzyCompare(lhs.aspectRatio, rhs.aspectRatio) && qFuzzyCompare(lhs.minEdgeLength, rhs.minEdgeLength)
+      && lhs.imageImportOptions.maxSize == rhs.imageImportOptions.maxSize && lhs.imageImportOptions.format == rhs.imageImportOptions.format
+      && lhs.imageImportOptions.quality == rhs.imageImportOptions.quality;
+}
+
+static int key(const NodeState & node)
+{
+    return node.index;
+}
+
+static std::pair<int, int> key(const EdgeState & edge)
+{
+    return { edge.index0, edge.index1 };
+}
+
+// Walks two sorted vectors in parallel and records the elements that were added, removed or changed
+template<typename T, typename C>
+static void diff(const std::vector<T> & before, const std::vector<T> & after, std::vector<C> & changes)
+{
+    auto b = before.begin();
+    auto a = after.begin();
+    while (b != before.end() || a != after.end()) {
+        C change;
+        if (a == after.end() || (b != before.end() && key(*b) < key(*a))) {
+            change.hasBefore = true;
+            change.before = *b++;
+        } else if (b == before.end() || key(*a) < key(*b)) {
+            change.hasAfter = true;
+            change.after = *a++;
+        } else {
+            if (*b == *a) {
+                b++;
+                a++;
+                continue;
+            }
+            change.hasBefore = change.hasAfter = true;
+            change.before = *b++;
+            change.after = *a++;
+        }
+        changes.push_back(change);
+    }
+}
+
+UndoCommand::UndoCommand(const MindMapState & before, const MindMapState & after)
+  : m_designChanged(!(before.design == after.design))
+{
+    if (m_designChanged) {
+        m_designBefore = before.design;
+        m_designAfter = after.design;
+    }
+
+    diff(before.nodes, after.nodes, m_nodeChanges);
+    diff(before.edges, after.edges, m_edgeChanges);
+}
+
+bool UndoCommand::isEmpty() const
+{
+    return !m_designChanged && m_nodeChanges.empty() && m_edgeChanges.empty();
+}
+
+size_t UndoCommand::byteSize() const
+{
+    size_t size = sizeof(*this) + m_nodeChanges.capacity() * sizeof(Change<NodeState>) + m_edgeChanges.capacity() * sizeof(Change<EdgeState>);
+    for (auto && change : m_nodeChanges) {
+        size += static_cast<size_t>(change.before.text.capacity() + change.after.text.capacity()) * sizeof(QChar);
+    }
+    for (auto && change : m_edgeChanges) {
+        size += static_cast<size_t>(change.before.text.capacity() + change.after.text.capacity()) * sizeof(QChar);
+    }
+    return size;
+}
+
+static QDataStream & operator<<(QDataStream & stream, const Design & design)
+{
+    return stream << design.backgroundColor << design.edgeColor << design.gridColor << design.edgeWidth << design.textSize << design.cornerRadius
+                  << design.aspectRatio << design.minEdgeLength << design.imageImportOptions.maxSize << design.imageImportOptions.format
+                  << design.imageImportOptions.quality;
+}
+
+static QDataStream & operator>>(QDataStream & stream, Design & design)
+{
+    return stream >> design.backgroundColor >> design.edgeColor >> design.gridColor >> design.edgeWidth >> design.textSize >> design.cornerRadius
+      >> design.aspectRatio >> design.minEdgeLength >> design.imageImportOptions.maxSize >> design.imageImportOptions.format
+      >> design.imageImportOptions.quality;
+}
+
+static QDataStream & operator<<(QDataStream & stream, const NodeState & node)
+{
+    return stream << node.index << node.location << node.size << node.text << node.color << node.textColor << static_cast<quint64>(node.imageRef);
+}
+
+static QDataStream & operator>>(QDataStream & stream, NodeState & node)
+{
+    quint64 imageRef = 0;
+    stream >> node.index >> node.location >> node.size >> node.text >> node.color >> node.textColor >> imageRef;
+    node.imageRef = static_cast<size_t>(imageRef);
+    return stream;
+}
+
+static QDataStream & operator<<(QDataStream & stream, const EdgeState & edge)
+{
+    return stream << edge.index0 << edge.index1 << static_cast<qint32>(edge.arrowMode) << edge.reversed << edge.text;
+}
+
+static QDataStream & operator>>(QDataStream & stream, EdgeState & edge)
+{
+    qint32 arrowMode = 0;
+    stream >> edge.index0 >> edge.index1 >> arrowMode >> edge.reversed >> edge.text;
+    edge.arrowMode = static_cast<Edge::ArrowMode>(arrowMode);
+    return stream;
+}
+
+template<typename C>
+static void writeChanges(QDataStream & stream, const std::vector<C> & changes)
+{
+    stream << static_cast<quint32>(changes.size());
+    for (auto && change : changes) {
+        stream << change.hasBefore << change.hasAfter;
+        if (change.hasBefore) {
+            stream << change.before;
+        }
+        if (change.hasAfter) {
+            stream << change.after;
+        }
+    }
+}
+
+template<typename C>
+static void readChanges(QDataStream & stream, std::vector<C> & changes)
+{
+    quint32 count = 0;
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        C change;
+        stream >> change.hasBefore >> change.hasAfter;
+        if (change.hasBefore) {
+            stream >> change.before;
+        }
+        if (change.hasAfter) {
+            stream >> change.after;
+        }
+        changes.push_back(change);
+    }
+}
+
+QByteArray UndoCommand::toBytes() const
+{
+    QByteArray bytes;
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+    stream << m_designChanged;
+    if (m_designChanged) {
+        stream << m_designBefore << m_designAfter;
+    }
+    writeChanges(stream, m_nodeChanges);
+    writeChanges(stream, m_edgeChanges);
+    return bytes;
+}
+
+UndoCommand UndoCommand::fromBytes(const QByteArray & bytes)
+{
+    UndoCommand command;
+    QDataStream stream(bytes);
+    stream >> command.m_designChanged;
+    if (command.m_designChanged) {
+        stream >> command.m_designBefore >> command.m_designAfter;
+    }
+    readChanges(stream, command.m_nodeChanges);
+    readChanges(stream, command.m_edgeChanges);
+    return command;
+}
+
+UndoCommand::Result UndoCommand::undo(MindMapData & mindMapData) const
+{
+    return apply(mindMapData, false);
+}
+
+void UndoCommand::undo(MindMapState & state) const
+{
+    apply(state, false);
+}
+
+UndoCommand::Result UndoCommand::redo(MindMapData & mindMapData) const
+{
+    return apply(mindMapData, true);
+}
+
+void UndoCommand::redo(MindMapState & state) const
+{
+    apply(state, true);
+}
+
+// Only the setters of changed values are called, as some of them update every node or edge
+static void applyDesign(MindMapData & mindMapData, const Design & design)
+{
+    if (mindMapData.backgroundColor() != design.backgroundColor) {
+        mindMapData.setBackgroundColor(design.backgroundColor);
+    }
+    if (mindMapData.edgeColor() != design.edgeColor) {
+        mindMapData.setEdgeColor(design.edgeColor);
+    }
+    if (mindMapData.gridColor() != design.gridColor) {
+        mindMapData.setGridColor(design.gridColor);
+    }
+    if (!qFuzzyCompare(mindMapData.edgeWidth(), design.edgeWidth)) {
+        mindMapData.setEdgeWidth(design.edgeWidth);
+    }
+    if (mindMapData.textSize() != design.textSize) {
+        mindMapData.setTextSize(design.textSize);
+    }
+    if (mindMapData.cornerRadius() != design.cornerRadius) {
+        mindMapData.setCornerRadius(design.cornerRadius);
+    }
+    mindMapData.setAspectRatio(design.aspectRatio);
+    mindMapData.setMinEdgeLength(design.minEdgeLength);
+    mindMapData.setImageImportOptions(design.imageImportOptions);
+}
+
+static void applyNode(Node & node, const NodeState & state)
+{
+    if (node.location() != state.location) {
+        node.setLocation(state.location);
+    }
+    if (node.size() != state.size) {
+        node.setSize(state.size);
+    }
+    node.setText(state.text);
+    if (node.color() != state.color) {
+        node.setColor(state.color);
+    }
+    if (node.textColor() != state.textColor) {
+        node.setTextColor(state.textColor);
+    }
+    if (node.imageRef() != state.imageRef) {
+        node.setImageRef(state.imageRef);
+    }
+}
+
+static void applyEdge(Edge & edge, const EdgeState & state)
+{
+    edge.setArrowMode(state.arrowMode);
+    edge.setReversed(state.reversed);
+    edge.setText(state.text);
+}
+
+UndoCommand::Result UndoCommand::apply(MindMapData & mindMapData, bool toAfter) const
+{
+    Result result;
+    auto && graph = mindMapData.graph();
+
+    // Removals first, as removing a node removes also its edges
+    for (auto && change : m_edgeChanges) {
+        if (!(toAfter ? change.hasAfter : change.hasBefore)) {
+            const auto & edge = toAfter ? change.before : change.after;
+            graph.deleteEdge(edge.index0, edge.index1);
+        }
+    }
+
+    for (auto && change : m_nodeChanges) {
+        if (!(toAfter ? change.hasAfter : change.hasBefore)) {
+            graph.deleteNode((toAfter ? change.before : change.after).index);
+        }
+    }
+
+    std::unordered_map<int, NodePtr> nodes;
+    if (!m_nodeChanges.empty() || !m_edgeChanges.empty()) {
+        for (auto && node : graph.getNodes()) {
+            nodes[node->index()] = node;
+        }
+    }
+
+    for (auto && change : m_nodeChanges) {
+        if (toAfter ? change.hasAfter : change.hasBefore) {
+            const auto & state = toAfter ? change.after : change.before;
+            auto && node = nodes[state.index];
+            if (!node) {
+                node = std::make_shared<Node>();
+                node->setIndex(state.index);
+                graph.addNode(node);
+                result.addedNodes.push_back(node);
+            }
+            applyNode(*node, state);
+        }
+    }
+
+    std::map<std::pair<int, int>, EdgePtr> edges;
+    if (!m_edgeChanges.empty()) {
+        for (auto && edge : graph.getEdges()) {
+            edges[{ edge->sourceNode().index(), edge->targetNode().index() }] = edge;
+        }
+    }
+
+    for (auto && change : m_edgeChanges) {
+        if (toAfter ? change.hasAfter : change.hasBefore) {
+            const auto & state = toAfter ? change.after : change.before;
+            auto && edge = edges[key(state)];
+            if (!edge) {
+                edge = std::make_shared<Edge>(*nodes.at(state.index0), *nodes.at(state.index1));
+                graph.addEdge(edge);
+                result.addedEdges.push_back(edge);
+            }
+            applyEdge(*edge, state);
+        }
+    }
+
+    // The design is applied last so that new edges and nodes get its sizes and colors
+    if (m_designChanged) {
+        applyDesign(mindMapData, toAfter ? m_designAfter : m_designBefore);
+        result.designChanged = true;
+    }
+
+    return result;
+}
+
+template<typename T, typename C>
+static void applyChanges(std::vector<T> & elements, const std::vector<C> & changes, bool toAfter)
+{
+    for (auto && change : changes) {
+        const auto & from = toAfter ? change.before : change.after;
+        const auto & to = toAfter ? change.after : change.before;
+        const auto toKey = key((toAfter ? change.hasAfter : change.hasBefore) ? to : from);
+        auto iter = std::lower_bound(elements.begin(), elements.end(), toKey, [](const T & element, decltype(toKey) k) {
+            return key(element) < k;
+        });
+        const bool found = iter != elements.end() && key(*iter) == toKey;
+        if (toAfter ? change.hasAfter : change.hasBefore) {
+            if (found) {
+                *iter = to;
+            } else {
+                elements.insert(iter, to);
+            }
+        } else if (found) {
+            elements.erase(iter);
+        }
+    }
+}
+
+void UndoCommand::apply(MindMapState & state, bool toAfter) const
+{
+    if (m_designChanged) {
+        state.design = toAfter ? m_designAfter : m_designBefore;
+    }
+
+    applyChanges(state.nodes, m_nodeChanges, toAfter);
+    applyChanges(state.edges, m_edgeChanges, toAfter);
+}
@@ -0,0 +1,95 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef UNDO_COMMAND_HPP
+#define UNDO_COMMAND_HPP
+
+#include "edge.hpp"
+#include "mind_map_state.hpp"
+
+#include <QByteArray>
+
+#include <vector>
+
+class MindMapData;
+
+//! Reversible change between two states of a mind map. Only the changed nodes, edges and
+//! design are stored, so the size is proportional to the edit and not to the mind map.
+class UndoCommand
+{
+public:
+    UndoCommand(const MindMapState & before, const MindMapState & after);
+
+    //! What undo or redo changed in the mind map, so that the scene can be updated to match.
+    struct Result
+    {
+        //! Created nodes and edges that are not in the scene yet.
+        std::vector<NodePtr> addedNodes;
+
+        std::vector<EdgePtr> addedEdges;
+
+        bool designChanged = false;
+    };
+
+    bool isEmpty() const;
+
+    //! Approximate memory use in bytes.
+    size_t byteSize() const;
+
+    QByteArray toBytes() const;
+
+    static UndoCommand fromBytes(const QByteArray & bytes);
+
+    //! Changes the mind map in place from the after state to the before state.
+    Result undo(MindMapData & mindMapData) const;
+
+    void undo(MindMapState & state) const;
+
+    //! Changes the mind map in place from the before state to the after state.
+    Result redo(MindMapData & mindMapData) const;
+
+    void redo(MindMapState & state) const;
+
+private:
+    UndoCommand() = default;
+
+    template<typename T>
+    struct Change
+    {
+        bool hasBefore = false;
+
+        T before;
+
+        bool hasAfter = false;
+
+        T after;
+    };
+
+    Result apply(MindMapData & mindMapData, bool toAfter) const;
+
+    void apply(MindMapState & state, bool toAfter) const;
+
+    bool m_designChanged = false;
+
+    MindMapState::Design m_designBefore;
+
+    MindMapState::Design m_designAfter;
+
+    std::vector<Change<MindMapState::NodeState>> m_nodeChanges;
+
+    std::vector<Change<MindMapState::EdgeState>> m_edgeChanges;
+};
+
+#endif // UNDO_COMMAND_HPP
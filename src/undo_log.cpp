@@ -0,0 +1,282 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "undo_log.hpp"
+
+#include "alz_journal.hpp"
+#include "constants.hpp"
+#include "simple_logger.hpp"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+
+#include <cstring>
+
+// Log: MAGIC, VERSION, records.
+// Command record: COMMAND_RECORD, compressed command.
+// Stack record: STACK_RECORD, stack, offset of the record, STACK_END. The stack record is always the last one.
+static const char MAGIC[] = "HEIMERUL";
+
+static const int MAGIC_SIZE = sizeof(MAGIC) - 1;
+
+static const quint32 VERSION = 1;
+
+static const int HEADER_SIZE = MAGIC_SIZE + sizeof(quint32);
+
+static const quint8 COMMAND_RECORD = 'C';
+
+static const quint8 STACK_RECORD = 'S';
+
+static const quint32 STACK_END = 0x554e444f;
+
+static const int STACK_END_SIZE = sizeof(qint64) + sizeof(quint32);
+
+UndoLog::UndoLog(QString filePath)
+  : m_filePath(filePath)
+  , m_file(logPath(filePath))
+{
+}
+
+UndoLog::~UndoLog()
+{
+    unmap();
+}
+
+QString UndoLog::logPath(QString filePath)
+{
+    return filePath + Constants::Undo::LOG_FILE_EXTENSION;
+}
+
+static void writeFileInfo(QDataStream & stream, const QFileInfo & info)
+{
+    stream << info.size() << (info.exists() ? info.lastModified().toMSecsSinceEpoch() : 0);
+}
+
+QByteArray UndoLog::stamp(QString filePath)
+{
+    const QFileInfo info(filePath);
+    if (!info.exists()) {
+        return {};
+    }
+
+    QByteArray stamp;
+    QDataStream stream(&stamp, QIODevice::WriteOnly);
+    writeFileInfo(stream, info);
+    writeFileInfo(stream, QFileInfo(AlzJournal::journalPath(filePath)));
+    return stamp;
+}
+
+void UndoLog::remove(QString filePath)
+{
+    QFile::remove(logPath(filePath));
+}
+
+QString UndoLog::filePath() const
+{
+    return m_filePath;
+}
+
+static QByteArray rawData(const uchar * data, qint64 size)
+{
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(data), static_cast<int>(size));
+}
+
+static QDataStream & operator<<(QDataStream & stream, const std::vector<qint64> & offsets)
+{
+    stream << static_cast<quint32>(offsets.size());
+    for (auto && offset : offsets) {
+        stream << offset;
+    }
+    return stream;
+}
+
+static QDataStream & operator>>(QDataStream & stream, std::vector<qint64> & offsets)
+{
+    quint32 size = 0;
+    stream >> size;
+    offsets.clear();
+    for (quint32 i = 0; i < size && stream.status() == QDataStream::Ok; i++) {
+        qint64 offset = 0;
+        stream >> offset;
+        offsets.push_back(offset);
+    }
+    return stream;
+}
+
+bool UndoLog::readStack(Stack & stack)
+{
+    if (!map() || m_mappedSize < HEADER_SIZE + STACK_END_SIZE || std::memcmp(m_data, MAGIC, MAGIC_SIZE)) {
+        return false;
+    }
+
+    // The stack record is found through the offset at the end of the log
+    QDataStream stream(rawData(m_data, m_mappedSize));
+    quint32 version = 0;
+    qint64 offset = 0;
+    quint32 stackEnd = 0;
+    stream.skipRawData(MAGIC_SIZE);
+    stream >> version;
+    stream.device()->seek(m_mappedSize - STACK_END_SIZE);
+    stream >> offset >> stackEnd;
+    if (version != VERSION || stackEnd != STACK_END || offset < HEADER_SIZE || offset >= m_mappedSize - STACK_END_SIZE) {
+        juzzlin::L().warning() << "Ignoring invalid undo log '" << m_file.fileName().toStdString() << "'";
+        return false;
+    }
+
+    quint8 type = 0;
+    stream.device()->seek(offset);
+    stream >> type >> stack.stamp >> stack.undoCommands >> stack.redoCommands >> stack.savedCommand;
+    return stream.status() == QDataStream::Ok && type == STACK_RECORD;
+}
+
+QByteArray UndoLog::readCommand(qint64 offset)
+{
+    if (!map() || offset < HEADER_SIZE || offset >= m_mappedSize) {
+        return {};
+    }
+
+    QDataStream stream(rawData(m_data + offset, m_mappedSize - offset));
+    quint8 type = 0;
+    QByteArray command;
+    stream >> type >> command;
+    if (stream.status() != QDataStream::Ok || type != COMMAND_RECORD) {
+        juzzlin::L().error() << "Invalid undo command at " << offset << " in '" << m_file.fileName().toStdString() << "'";
+        return {};
+    }
+
+    return command;
+}
+
+qint64 UndoLog::commandSize(qint64 offset)
+{
+    if (!map() || offset < HEADER_SIZE || offset >= m_mappedSize) {
+        return -1;
+    }
+
+    // QDataStream stores the array size in front of the data
+    QDataStream stream(rawData(m_data + offset, m_mappedSize - offset));
+    quint8 type = 0;
+    quint32 size = 0;
+    stream >> type >> size;
+    if (stream.status() != QDataStream::Ok || type != COMMAND_RECORD || size == 0xffffffff || offset + static_cast<qint64>(size) > m_mappedSize) {
+        return -1;
+    }
+
+    return size;
+}
+
+qint64 UndoLog::appendCommand(const QByteArray & compressedCommand)
+{
+    if (!openForAppend()) {
+        return -1;
+    }
+
+    QByteArray record;
+    QDataStream stream(&record, QIODevice::WriteOnly);
+    stream << COMMAND_RECORD << compressedCommand;
+
+    const auto offset = m_file.size();
+    return append(record) ? offset : -1;
+}
+
+bool UndoLog::appendStack(const Stack & stack)
+{
+    if (!openForAppend()) {
+        return false;
+    }
+
+    QByteArray record;
+    QDataStream stream(&record, QIODevice::WriteOnly);
+    stream << STACK_RECORD << stack.stamp << stack.undoCommands << stack.redoCommands << stack.savedCommand;
+    stream << m_file.size() << STACK_END;
+    return append(record);
+}
+
+qint64 UndoLog::size() const
+{
+    return QFileInfo(m_file.fileName()).size();
+}
+
+// Starts a new log if there's no valid one
+bool UndoLog::openForAppend()
+{
+    if (!(m_file.openMode() & QIODevice::WriteOnly)) {
+        unmap();
+        m_file.close();
+        if (!m_file.open(QIODevice::ReadWrite)) {
+            juzzlin::L().error() << "Cannot open undo log '" << m_file.fileName().toStdString() << "': " << m_file.errorString().toStdString();
+            return false;
+        }
+    }
+
+    if (m_file.size() >= HEADER_SIZE && m_file.seek(0) && m_file.peek(MAGIC_SIZE) == QByteArray(MAGIC, MAGIC_SIZE)) {
+        return true;
+    }
+
+    QByteArray header;
+    QDataStream stream(&header, QIODevice::WriteOnly);
+    stream.writeRawData(MAGIC, MAGIC_SIZE);
+    stream << VERSION;
+    unmap();
+    if (!m_file.resize(0)) {
+        juzzlin::L().error() << "Cannot reset undo log '" << m_file.fileName().toStdString() << "': " << m_file.errorString().toStdString();
+        return false;
+    }
+
+    return append(header);
+}
+
+// Writes the whole record at once so that a crash can only tear the last record
+bool UndoLog::append(const QByteArray & data)
+{
+    if (!m_file.seek(m_file.size()) || m_file.write(data) != data.size() || !m_file.flush()) {
+        juzzlin::L().error() << "Cannot write undo log '" << m_file.fileName().toStdString() << "': " << m_file.errorString().toStdString();
+        return false;
+    }
+
+    return true;
+}
+
+bool UndoLog::map()
+{
+    if (!m_file.isOpen() && !m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    // Appended records are not in the current view
+    if (m_data && m_mappedSize == m_file.size()) {
+        return true;
+    }
+
+    unmap();
+    m_mappedSize = m_file.size();
+    m_data = m_mappedSize ? m_file.map(0, m_mappedSize) : nullptr;
+    if (!m_data) {
+        m_mappedSize = 0;
+        return false;
+    }
+
+    return true;
+}
+
+void UndoLog::unmap()
+{
+    if (m_data) {
+        m_file.unmap(m_data);
+        m_data = nullptr;
+        m_mappedSize = 0;
+    }
+}
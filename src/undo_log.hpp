@@ -0,0 +1,104 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef UNDO_LOG_HPP
+#define UNDO_LOG_HPP
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include <vector>
+
+//! Append-only file of compressed undo commands stored next to a mind map. Every save appends
+//! the commands that are not in the log yet, followed by a stack record that lists the commands
+//! of the undo and redo stacks by their offsets. Only the latest stack record is used. Commands are
+//! read lazily from a memory-mapped view, so a long history doesn't need to be kept in memory.
+//!
+//! The stack record is stamped with the size and modification time of the mind map file and its
+//! journal so that a log left behind by another version of the mind map is never applied.
+class UndoLog
+{
+public:
+    //! Stack record.
+    struct Stack
+    {
+        QByteArray stamp;
+
+        //! Offsets of the undo commands, the latest last.
+        std::vector<qint64> undoCommands;
+
+        //! Offsets of the redo commands, the latest last.
+        std::vector<qint64> redoCommands;
+
+        //! Offset of the command from the latest undo point to the saved mind map, or -1 if none.
+        qint64 savedCommand = -1;
+    };
+
+    //! \param filePath Path of the mind map file.
+    explicit UndoLog(QString filePath);
+
+    ~UndoLog();
+
+    static QString logPath(QString filePath);
+
+    //! Identifies the mind map file as it is on disk, or is empty if the file doesn't exist.
+    static QByteArray stamp(QString filePath);
+
+    static void remove(QString filePath);
+
+    QString filePath() const;
+
+    //! \return false if there's no valid log.
+    bool readStack(Stack & stack);
+
+    //! \return The compressed command at the given offset or an empty array on error.
+    QByteArray readCommand(qint64 offset);
+
+    //! Reads only the record header, so the command itself is not paged in.
+    //! \return Size of the compressed command at the given offset or -1 on error.
+    qint64 commandSize(qint64 offset);
+
+    //! Appends a compressed command and starts a new log if needed.
+    //! \return Offset of the command or -1 on error.
+    qint64 appendCommand(const QByteArray & compressedCommand);
+
+    bool appendStack(const Stack & stack);
+
+    qint64 size() const;
+
+private:
+    UndoLog(const UndoLog & other) = delete;
+    UndoLog & operator=(const UndoLog & other) = delete;
+
+    bool openForAppend();
+
+    bool append(const QByteArray & data);
+
+    //! Maps the whole file for reading, if not mapped already.
+    bool map();
+
+    void unmap();
+
+    QString m_filePath;
+
+    QFile m_file;
+
+    uchar * m_data = nullptr;
+
+    qint64 m_mappedSize = 0;
+};
+
+#endif // UNDO_LOG_HPP
@@ -15,32 +15,128 @@
 
 #include "undo_stack.hpp"
 
-UndoStack::UndoStack(size_t maxHistorySize)
-  : m_maxHistorySize(maxHistorySize)
+#include "simple_logger.hpp"
+
+#include <algorithm>
+
+UndoStack::Entry::Entry(UndoCommand command)
+  : m_command(std::make_unique<UndoCommand>(std::move(command)))
 {
+    updateByteSize();
 }
 
-void UndoStack::pushUndoPoint(const MindMapData & mindMapData)
+UndoStack::Entry::Entry(qint64 logOffset, qint64 logSize)
+  : m_logOffset(logOffset)
+  , m_logSize(logSize)
 {
-    m_undoStack.push_back(std::make_unique<MindMapData>(mindMapData));
+    updateByteSize();
+}
 
-    if (m_undoStack.size() > m_maxHistorySize && m_maxHistorySize) {
-        m_undoStack.pop_front();
+bool UndoStack::Entry::isCompressed() const
+{
+    return !m_command;
+}
+
+void UndoStack::Entry::compress()
+{
+    if (m_command) {
+        // A logged command is read back from the log
+        if (m_logOffset < 0) {
+            m_compressed = qCompress(m_command->toBytes(), Constants::Undo::COMPRESSION_LEVEL);
+        }
+        m_command.reset();
+        updateByteSize();
+    }
+}
+
+size_t UndoStack::Entry::byteSize() const
+{
+    return m_byteSize;
+}
+
+qint64 UndoStack::Entry::logOffset() const
+{
+    return m_logOffset;
+}
+
+qint64 UndoStack::Entry::logSize() const
+{
+    return m_logSize;
+}
+
+bool UndoStack::Entry::log(UndoLog & log)
+{
+    const auto compressed = m_command ? qCompress(m_command->toBytes(), Constants::Undo::COMPRESSION_LEVEL) : m_compressed;
+    const auto offset = log.appendCommand(compressed);
+    if (offset < 0) {
+        return false;
+    }
+
+    m_logOffset = offset;
+    m_logSize = compressed.size();
+    m_compressed.clear();
+    updateByteSize();
+    return true;
+}
+
+void UndoStack::Entry::unlog(UndoLog & log)
+{
+    if (m_logOffset >= 0 && !m_command) {
+        m_compressed = log.readCommand(m_logOffset);
     }
+    m_logOffset = -1;
+    m_logSize = 0;
+    updateByteSize();
 }
 
-void UndoStack::pushRedoPoint(const MindMapData & mindMapData)
+std::unique_ptr<UndoCommand> UndoStack::Entry::take(UndoLog * log)
 {
-    m_redoStack.push_back(std::make_unique<MindMapData>(mindMapData));
+    if (m_command) {
+        return std::move(m_command);
+    }
 
-    if (m_redoStack.size() > m_maxHistorySize && m_maxHistorySize) {
-        m_redoStack.pop_front();
+    const auto bytes = qUncompress(m_compressed.isEmpty() && log ? log->readCommand(m_logOffset) : m_compressed);
+    if (bytes.isEmpty()) {
+        return {};
     }
+
+    return std::make_unique<UndoCommand>(UndoCommand::fromBytes(bytes));
+}
+
+void UndoStack::Entry::updateByteSize()
+{
+    m_byteSize = m_command ? m_command->byteSize() : sizeof(*this) + static_cast<size_t>(m_compressed.capacity());
+}
+
+UndoStack::UndoStack(size_t maxHistorySize, size_t memoryBudget)
+  : m_maxHistorySize(maxHistorySize)
+  , m_memoryBudget(memoryBudget)
+{
+}
+
+void UndoStack::pushUndoPoint(const MindMapData & mindMapData)
+{
+    auto undoPoint = std::make_unique<MindMapState>(MindMapState::capture(mindMapData));
+    if (m_undoPoint) {
+        m_undoStack.emplace_back(UndoCommand(*m_undoPoint, *undoPoint));
+    }
+    m_undoPoint = std::move(undoPoint);
+    m_undoPointSize = m_undoPoint->byteSize();
+
+    // The latest undo point counts as one
+    if (m_undoStack.size() + 1 > m_maxHistorySize && m_maxHistorySize) {
+        m_undoStack.pop_front();
+    }
+
+    trim();
 }
 
 void UndoStack::clear()
 {
+    m_log.reset();
     m_undoStack.clear();
+    m_undoPoint.reset();
+    m_undoPointSize = 0;
     m_redoStack.clear();
 }
 
@@ -51,18 +147,38 @@ void UndoStack::clearRedoStack()
 
 bool UndoStack::isUndoable() const
 {
-    return !m_undoStack.empty();
+    return m_undoPoint != nullptr;
 }
 
-std::unique_ptr<MindMapData> UndoStack::undo()
+UndoCommand::Result UndoStack::undo(MindMapData & mindMapData)
 {
+    UndoCommand::Result result;
     if (isUndoable()) {
-        auto head = std::move(m_undoStack.back());
-        m_undoStack.pop_back();
-        return head;
-    }
+        UndoCommand command(*m_undoPoint, MindMapState::capture(mindMapData));
+        result = command.undo(mindMapData);
+        m_redoStack.emplace_back(std::move(command));
+        if (m_redoStack.size() > m_maxHistorySize && m_maxHistorySize) {
+            m_redoStack.pop_front();
+        }
 
-    return {};
+        // Step the latest undo point back to the previous one. The older undo points can't be reached without the command.
+        const auto previous = !m_undoStack.empty() ? m_undoStack.back().take(m_log.get()) : nullptr;
+        if (previous) {
+            previous->undo(*m_undoPoint);
+            m_undoStack.pop_back();
+            m_undoPointSize = m_undoPoint->byteSize();
+        } else {
+            if (!m_undoStack.empty()) {
+                juzzlin::L().warning() << "Cannot read undo command, dropping " << m_undoStack.size() << " undo steps";
+                m_undoStack.clear();
+            }
+            m_undoPoint.reset();
+            m_undoPointSize = 0;
+        }
+
+        trim();
+    }
+    return result;
 }
 
 bool UndoStack::isRedoable() const
@@ -70,13 +186,173 @@ bool UndoStack::isRedoable() const
     return !m_redoStack.empty();
 }
 
-std::unique_ptr<MindMapData> UndoStack::redo()
+UndoCommand::Result UndoStack::redo(MindMapData & mindMapData)
 {
+    UndoCommand::Result result;
     if (isRedoable()) {
-        auto head = std::move(m_redoStack.back());
+        const auto command = m_redoStack.back().take(m_log.get());
+        if (!command) {
+            juzzlin::L().warning() << "Cannot read redo command, dropping " << m_redoStack.size() << " redo steps";
+            m_redoStack.clear();
+            return result;
+        }
+        result = command->redo(mindMapData);
         m_redoStack.pop_back();
-        return head;
+    }
+    return result;
+}
+
+size_t UndoStack::byteSize() const
+{
+    size_t size = m_undoPointSize;
+    for (auto && entry : m_undoStack) {
+        size += entry.byteSize();
+    }
+    for (auto && entry : m_redoStack) {
+        size += entry.byteSize();
+    }
+    return size;
+}
+
+bool UndoStack::save(QString filePath, const MindMapData & mindMapData)
+{
+    const auto stamp = UndoLog::stamp(filePath);
+    if (stamp.isEmpty()) {
+        return false;
+    }
+
+    // Start over when saved to another file or when most of the log is no longer in use
+    qint64 usedSize = 0;
+    for (auto && entries : { &m_undoStack, &m_redoStack }) {
+        for (auto && entry : *entries) {
+            usedSize += entry.logSize();
+        }
+    }
+
+    if (m_log && (m_log->filePath() != filePath || m_log->size() > std::max(Constants::Undo::LOG_MIN_COMPACT_SIZE, usedSize * Constants::Undo::LOG_COMPACT_FACTOR))) {
+        closeLog();
+    }
+
+    if (!m_log) {
+        UndoLog::remove(filePath);
+        m_log = std::make_unique<UndoLog>(filePath);
+    }
+
+    UndoLog::Stack stack;
+    stack.stamp = stamp;
+    for (auto && entries : { std::make_pair(&m_undoStack, &stack.undoCommands), std::make_pair(&m_redoStack, &stack.redoCommands) }) {
+        for (auto && entry : *entries.first) {
+            if (entry.logOffset() < 0 && !entry.log(*m_log)) {
+                return false;
+            }
+            entries.second->push_back(entry.logOffset());
+        }
+    }
+
+    // The mind map may have changed after the latest undo point
+    if (m_undoPoint) {
+        const UndoCommand command(*m_undoPoint, MindMapState::capture(mindMapData));
+        stack.savedCommand = m_log->appendCommand(qCompress(command.toBytes(), Constants::Undo::COMPRESSION_LEVEL));
+        if (stack.savedCommand < 0) {
+            return false;
+        }
+    }
+
+    if (!m_log->appendStack(stack)) {
+        return false;
+    }
+
+    juzzlin::L().debug() << "Saved " << stack.undoCommands.size() << " undo and " << stack.redoCommands.size() << " redo steps to '"
+                         << UndoLog::logPath(filePath).toStdString() << "' of " << m_log->size() << " bytes";
+
+    trim();
+    return true;
+}
+
+bool UndoStack::load(QString filePath, const MindMapData & mindMapData)
+{
+    clear();
+
+    auto log = std::make_unique<UndoLog>(filePath);
+    UndoLog::Stack stack;
+    if (!log->readStack(stack)) {
+        return false;
+    }
+
+    if (stack.stamp != UndoLog::stamp(filePath)) {
+        juzzlin::L().warning() << "Ignoring stale undo log '" << UndoLog::logPath(filePath).toStdString() << "'";
+        return false;
+    }
+
+    if (stack.savedCommand >= 0) {
+        const auto command = log->readCommand(stack.savedCommand);
+        if (command.isEmpty()) {
+            return false;
+        }
+        m_undoPoint = std::make_unique<MindMapState>(MindMapState::capture(mindMapData));
+        UndoCommand::fromBytes(qUncompress(command)).undo(*m_undoPoint);
+        m_undoPointSize = m_undoPoint->byteSize();
+    }
+
+    // Commands are read when undone or redone. Their sizes tell save() how much of the log is still in use.
+    for (auto && offset : stack.undoCommands) {
+        m_undoStack.emplace_back(offset, std::max(log->commandSize(offset), qint64 { 0 }));
+    }
+
+    for (auto && offset : stack.redoCommands) {
+        m_redoStack.emplace_back(offset, std::max(log->commandSize(offset), qint64 { 0 }));
+    }
+
+    m_log = std::move(log);
+
+    juzzlin::L().debug() << "Loaded " << m_undoStack.size() << " undo and " << m_redoStack.size() << " redo steps";
+
+    trim();
+    return true;
+}
+
+void UndoStack::closeLog()
+{
+    if (m_log) {
+        for (auto && entries : { &m_undoStack, &m_redoStack }) {
+            for (auto && entry : *entries) {
+                entry.unlog(*m_log);
+            }
+        }
+        m_log.reset();
+    }
+}
+
+// Compresses the entries that are farther than the hot budget from the current state
+// and drops the oldest ones until the rest fit in the memory budget
+void UndoStack::trim()
+{
+    size_t hotSize = 0;
+    for (auto && entries : { &m_undoStack, &m_redoStack }) {
+        for (auto entry = entries->rbegin(); entry != entries->rend(); entry++) {
+            if (!entry->isCompressed()) {
+                hotSize += entry->byteSize();
+                if (hotSize > Constants::Undo::HOT_BUDGET) {
+                    entry->compress();
+                }
+            }
+        }
+    }
+
+    auto size = byteSize();
+    while (m_memoryBudget && size > m_memoryBudget && (!m_undoStack.empty() || !m_redoStack.empty())) {
+        auto && entries = !m_undoStack.empty() ? m_undoStack : m_redoStack;
+        size -= entries.front().byteSize();
+        entries.pop_front();
+    }
+
+    size_t compressedCount = 0;
+    for (auto && entries : { &m_undoStack, &m_redoStack }) {
+        compressedCount += static_cast<size_t>(std::count_if(entries->begin(), entries->end(), [](const Entry & entry) {
+            return entry.isCompressed();
+        }));
     }
 
-    return {};
+    juzzlin::L().debug() << "Undo memory: " << size << " bytes in " << m_undoStack.size() << " undo and " << m_redoStack.size()
+                         << " redo steps, " << compressedCount << " compressed, latest undo point " << m_undoPointSize << " bytes";
 }
@@ -16,41 +16,120 @@
 #ifndef UNDO_STACK_HPP
 #define UNDO_STACK_HPP
 
-#include "mind_map_data.hpp"
+#include "constants.hpp"
+#include "undo_command.hpp"
+#include "undo_log.hpp"
+
+#include <QByteArray>
+#include <QString>
 
 #include <list>
 #include <memory>
 
+class MindMapData;
+
+//! Undo history made of UndoCommands. Only the state of the latest undo point is kept in full,
+//! as plain data, and older undo points are reached by undoing the commands between them.
+//! The latest commands are kept as they are and older ones are compressed. The oldest ones are
+//! dropped when the history doesn't fit in the memory budget. The history can be saved to an
+//! UndoLog next to the mind map, after which the compressed commands are read from the log when needed.
 class UndoStack
 {
 public:
     //! \param maxHistorySize The size of undo stack or 0 for "unlimited".
-    UndoStack(size_t maxHistorySize = 0);
+    //! \param memoryBudget The maximum memory use in bytes or 0 for "unlimited".
+    UndoStack(size_t maxHistorySize = 0, size_t memoryBudget = Constants::Undo::MEMORY_BUDGET);
 
     void pushUndoPoint(const MindMapData & mindMapData);
 
-    void pushRedoPoint(const MindMapData & mindMapData);
-
     void clear();
 
     void clearRedoStack();
 
     bool isUndoable() const;
 
-    std::unique_ptr<MindMapData> undo();
+    //! Reverts the mind map in place to the latest undo point. The reverted changes can be redone.
+    UndoCommand::Result undo(MindMapData & mindMapData);
 
     bool isRedoable() const;
 
-    std::unique_ptr<MindMapData> redo();
+    //! Reapplies the latest undone changes to the mind map in place.
+    UndoCommand::Result redo(MindMapData & mindMapData);
+
+    //! Approximate memory use in bytes.
+    size_t byteSize() const;
+
+    //! Saves the history of the mind map just saved to filePath to its undo log.
+    bool save(QString filePath, const MindMapData & mindMapData);
+
+    //! Restores the history of the mind map just loaded from filePath, if its undo log matches the file.
+    bool load(QString filePath, const MindMapData & mindMapData);
 
 private:
-    using MindMapDataVector = std::list<std::unique_ptr<MindMapData>>;
+    //! A command that is either hot, compressed or only in the undo log.
+    class Entry
+    {
+    public:
+        explicit Entry(UndoCommand command);
+
+        Entry(qint64 logOffset, qint64 logSize);
+
+        bool isCompressed() const;
+
+        void compress();
+
+        size_t byteSize() const;
+
+        qint64 logOffset() const;
+
+        qint64 logSize() const;
+
+        //! Appends the command to the log. The compressed command is then read from the log when needed.
+        bool log(UndoLog & log);
+
+        //! Reads the command from the log into memory so that the log is no longer needed.
+        void unlog(UndoLog & log);
 
-    MindMapDataVector m_undoStack;
+        //! Inflates the command if needed.
+        //! \return nullptr if the command can't be read, e.g. from a corrupted log.
+        std::unique_ptr<UndoCommand> take(UndoLog * log);
 
-    MindMapDataVector m_redoStack;
+    private:
+        void updateByteSize();
+
+        std::unique_ptr<UndoCommand> m_command;
+
+        QByteArray m_compressed;
+
+        size_t m_byteSize = 0;
+
+        qint64 m_logOffset = -1;
+
+        qint64 m_logSize = 0;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    //! Moves the commands that are only in the log into memory and closes the log.
+    void closeLog();
+
+    void trim();
+
+    //! Changes between consecutive undo points, the latest last.
+    EntryList m_undoStack;
+
+    //! State of the latest undo point.
+    std::unique_ptr<MindMapState> m_undoPoint;
+
+    size_t m_undoPointSize = 0;
+
+    EntryList m_redoStack;
 
     size_t m_maxHistorySize;
+
+    size_t m_memoryBudget;
+
+    std::unique_ptr<UndoLog> m_log;
 };
 
 #endif // UNDO_STACK_HPP
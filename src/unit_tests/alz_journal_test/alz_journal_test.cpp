@@ -0,0 +1,243 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "alz_journal_test.hpp"
+
+#include "alz_journal.hpp"
+#include "alz_serializer.hpp"
+#include "mind_map_data.hpp"
+#include "test_mode.hpp"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+AlzJournalTest::AlzJournalTest()
+{
+    TestMode::setEnabled(true);
+}
+
+static void writeBase(MindMapData & data, QString filePath)
+{
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(AlzSerializer::toXml(data));
+}
+
+static std::unique_ptr<MindMapData> readBase(QString filePath)
+{
+    QFile file(filePath);
+    file.open(QIODevice::ReadOnly);
+    return AlzSerializer::fromXml(file.readAll());
+}
+
+static void addNodes(MindMapData & data, int count)
+{
+    for (int i = 0; i < count; i++) {
+        const auto node = std::make_shared<Node>();
+        node->setLocation(QPointF(i, i));
+        node->setText(QString("Node %1").arg(i));
+        data.graph().addNode(node);
+    }
+}
+
+void AlzJournalTest::testDesignChangeNeedsFullSave()
+{
+    QTemporaryDir dir;
+    const auto filePath = dir.filePath("test.alz");
+    MindMapData data;
+    addNodes(data, 2);
+    writeBase(data, filePath);
+
+    const auto saved = AlzJournal::snapshot(data, filePath);
+    data.setBackgroundColor(QColor(1, 2, 3));
+
+    AlzJournal::Snapshot current;
+    QByteArray records;
+    QVERIFY(!AlzJournal::diff(data, filePath, saved, current, records));
+}
+
+void AlzJournalTest::testNoChanges()
+{
+    QTemporaryDir dir;
+    const auto filePath = dir.filePath("test.alz");
+    MindMapData data;
+    addNodes(data, 2);
+    writeBase(data, filePath);
+
+    const auto saved = AlzJournal::snapshot(data, filePath);
+    AlzJournal::Snapshot current;
+    QByteArray records;
+    QVERIFY(AlzJournal::diff(data, filePath, saved, current, records));
+    QVERIFY(records.isEmpty());
+}
+
+void AlzJournalTest::testReplay()
+{
+    QTemporaryDir dir;
+    const auto filePath = dir.filePath("test.alz");
+    MindMapData data;
+    addNodes(data, 3);
+    data.graph().addEdge(std::make_shared<Edge>(*data.graph().getNode(0), *data.graph().getNode(1)));
+    writeBase(data, filePath);
+
+    // Change a node, delete a node with its edge, and add a node with an edge
+    auto saved = AlzJournal::snapshot(data, filePath);
+    data.graph().getNode(2)->setText("Changed");
+    data.graph().deleteNode(1);
+    addNodes(data, 1);
+    const auto edge = std::make_shared<Edge>(*data.graph().getNode(0), *data.graph().getNode(3));
+    edge->setText("Added");
+    data.graph().addEdge(edge);
+
+    AlzJournal::Snapshot current;
+    QByteArray records;
+    QVERIFY(AlzJournal::diff(data, filePath, saved, current, records));
+    QVERIFY(!records.contains("<node index=\"0\""));
+    QVERIFY(AlzJournal::append(filePath, records));
+
+    // Records are appended to the same journal
+    saved = current;
+    data.graph().getNode(0)->setLocation(QPointF(42, 42));
+    QVERIFY(AlzJournal::diff(data, filePath, saved, current, records));
+    QVERIFY(AlzJournal::append(filePath, records));
+
+    const auto inData = readBase(filePath);
+    AlzJournal::replay(filePath, *inData);
+    QCOMPARE(inData->graph().numNodes(), size_t { 3 });
+    QCOMPARE(inData->graph().getNode(0)->location(), QPointF(42, 42));
+    QCOMPARE(inData->graph().getNode(2)->text(), QString("Changed"));
+    QCOMPARE(inData->graph().getNode(3)->text(), QString("Node 0"));
+    QCOMPARE(inData->graph().getEdges().size(), size_t { 1 });
+    QCOMPARE(inData->graph().getEdges().at(0)->targetNode().index(), 3);
+    QCOMPARE(inData->graph().getEdges().at(0)->text(), QString("Added"));
+}
+
+void AlzJournalTest::testReplayReaddedNode()
+{
+    QTemporaryDir dir;
+    const auto filePath = dir.filePath("test.alz");
+    MindMapData data;
+    addNodes(data, 2);
+    data.graph().addEdge(std::make_shared<Edge>(*data.graph().getNode(0), *data.graph().getNode(1)));
+    writeBase(data, filePath);
+
+    // Delete a node with its edge and add them back with the same indices like undo does
+    auto saved = AlzJournal::snapshot(data, filePath);
+    data.graph().deleteNode(1);
+    AlzJournal::Snapshot current;
+    QByteArray records;
+    QVERIFY(AlzJournal::diff(data, filePath, saved, current, records));
+    QVERIFY(AlzJournal::append(filePath, records));
+
+    saved = current;
+    const auto node = std::make_shared<Node>();
+    node->setIndex(1);
+    node->setText("Re-added");
+    data.graph().addNode(node);
+    const auto edge = std::make_shared<Edge>(*data.graph().getNode(0), *node);
+    edge->setText("Re-added");
+    data.graph().addEdge(edge);
+    QVERIFY(AlzJournal::diff(data, filePath, saved, current, records));
+    QVERIFY(AlzJournal::append(filePath, records));
+
+    const auto inData = readBase(filePath);
+    AlzJournal::replay(filePath, *inData);
+    QCOMPARE(inData->graph().numNodes(), size_t { 2 });
+    QCOMPARE(inData->graph().getNode(1)->text(), QString("Re-added"));
+    QCOMPARE(inData->graph().getEdges().size(), size_t { 1 });
+    QCOMPARE(&inData->graph().getEdges().at(0)->targetNode(), inData->graph().getNode(1).get());
+    QCOMPARE(inData->graph().getEdges().at(0)->text(), QString("Re-added"));
+}
+
+void AlzJournalTest::testStaleJournal()
+{
+    QTemporaryDir dir;
+    const auto filePath = dir.filePath("test.alz");
+    MindMapData data;
+    addNodes(data, 1);
+    writeBase(data, filePath);
+
+    const auto saved = AlzJournal::snapshot(data, filePath);
+    addNodes(data, 1);
+    AlzJournal::Snapshot current;
+    QByteArray records;
+    QVERIFY(AlzJournal::diff(data, filePath, saved, current, records));
+    QVERIFY(AlzJournal::append(filePath, records));
+
+    // Rewrite the base file behind the journal's back
+    addNodes(data, 1);
+    writeBase(data, filePath);
+    QVERIFY(!AlzJournal::diff(data, filePath, saved, current, records));
+
+    const auto inData = readBase(filePath);
+    AlzJournal::replay(filePath, *inData);
+    QCOMPARE(inData->graph().numNodes(), size_t { 3 });
+}
+
+void AlzJournalTest::testAppendAfterTruncatedJournal()
+{
+    QTemporaryDir dir;
+    const auto filePath = dir.filePath("test.alz");
+    MindMapData data;
+    writeBase(data, filePath);
+
+    auto saved = AlzJournal::snapshot(data, filePath);
+    addNodes(data, 2);
+    AlzJournal::Snapshot current;
+    QByteArray records;
+    QVERIFY(AlzJournal::diff(data, filePath, saved, current, records));
+    QVERIFY(AlzJournal::append(filePath, records));
+
+    QFile journal(AlzJournal::journalPath(filePath));
+    QVERIFY(journal.resize(journal.size() - 10));
+
+    // Continue editing the recovered mind map like after a crash
+    const auto recoveredData = readBase(filePath);
+    AlzJournal::replay(filePath, *recoveredData);
+    QCOMPARE(recoveredData->graph().numNodes(), size_t { 1 });
+    saved = AlzJournal::snapshot(*recoveredData, filePath);
+    addNodes(*recoveredData, 2);
+    QVERIFY(AlzJournal::diff(*recoveredData, filePath, saved, current, records));
+    QVERIFY(AlzJournal::append(filePath, records));
+
+    const auto inData = readBase(filePath);
+    AlzJournal::replay(filePath, *inData);
+    QCOMPARE(inData->graph().numNodes(), size_t { 3 });
+}
+
+void AlzJournalTest::testTruncatedJournal()
+{
+    QTemporaryDir dir;
+    const auto filePath = dir.filePath("test.alz");
+    MindMapData data;
+    writeBase(data, filePath);
+
+    const auto saved = AlzJournal::snapshot(data, filePath);
+    addNodes(data, 2);
+    AlzJournal::Snapshot current;
+    QByteArray records;
+    QVERIFY(AlzJournal::diff(data, filePath, saved, current, records));
+    QVERIFY(AlzJournal::append(filePath, records));
+
+    QFile journal(AlzJournal::journalPath(filePath));
+    QVERIFY(journal.resize(journal.size() - 10));
+
+    const auto inData = readBase(filePath);
+    AlzJournal::replay(filePath, *inData);
+    QCOMPARE(inData->graph().numNodes(), size_t { 1 });
+}
+
+QTEST_GUILESS_MAIN(AlzJournalTest)
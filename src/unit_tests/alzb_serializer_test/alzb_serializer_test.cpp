@@ -0,0 +1,204 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "alzb_serializer_test.hpp"
+
+#include "alz_serializer.hpp"
+#include "alzb_serializer.hpp"
+#include "mind_map_data.hpp"
+#include "test_mode.hpp"
+
+#include <stdexcept>
+
+AlzbSerializerTest::AlzbSerializerTest()
+{
+    TestMode::setEnabled(true);
+}
+
+static std::shared_ptr<Node> addNode(MindMapData & data, QString text)
+{
+    const auto node = std::make_shared<Node>();
+    node->setColor(QColor(1, 2, 3));
+    node->setLocation(QPointF(333.333, 666.666));
+    node->setSize(QSize(123, 321));
+    node->setText(text);
+    node->setTextColor(QColor(4, 5, 6));
+    data.graph().addNode(node);
+    return node;
+}
+
+static void compareGraphs(MindMapData & outData, MindMapData & inData)
+{
+    QCOMPARE(inData.graph().numNodes(), outData.graph().numNodes());
+    for (auto && outNode : outData.graph().getNodes()) {
+        const auto node = inData.graph().getNode(outNode->index());
+        QCOMPARE(node->color(), outNode->color());
+        QCOMPARE(node->location(), outNode->location());
+        QCOMPARE(node->size(), outNode->size());
+        QCOMPARE(node->text(), outNode->text());
+        QCOMPARE(node->textColor(), outNode->textColor());
+        const auto outEdges = outData.graph().getEdgesFromNode(outNode);
+        const auto edges = inData.graph().getEdgesFromNode(node);
+        QCOMPARE(edges.size(), outEdges.size());
+    }
+}
+
+void AlzbSerializerTest::testConversionFromXml()
+{
+    MindMapData outData;
+    const auto node0 = addNode(outData, "Lorem");
+    const auto node1 = addNode(outData, "ipsum");
+    outData.graph().addEdge(std::make_shared<Edge>(*node0, *node1));
+
+    const auto xmlData = AlzSerializer::fromXml(AlzSerializer::toXml(outData));
+    const auto inData = AlzbSerializer::fromBinary(AlzbSerializer::toBinary(*xmlData));
+    compareGraphs(outData, *inData);
+}
+
+void AlzbSerializerTest::testConversionToXml()
+{
+    MindMapData outData;
+    const auto node0 = addNode(outData, "Lorem");
+    const auto node1 = addNode(outData, "ipsum");
+    outData.graph().addEdge(std::make_shared<Edge>(*node0, *node1));
+
+    const auto binaryData = AlzbSerializer::fromBinary(AlzbSerializer::toBinary(outData));
+    const auto inData = AlzSerializer::fromXml(AlzSerializer::toXml(*binaryData));
+    compareGraphs(outData, *inData);
+}
+
+void AlzbSerializerTest::testCorruptedData()
+{
+    MindMapData outData;
+    addNode(outData, "Lorem ipsum");
+    const auto binary = AlzbSerializer::toBinary(outData);
+    QVERIFY_EXCEPTION_THROWN(AlzbSerializer::fromBinary(binary.left(binary.size() / 2)), std::runtime_error);
+    QVERIFY_EXCEPTION_THROWN(AlzbSerializer::fromBinary(QByteArray("<?xml version=\"1.0\"?>")), std::runtime_error);
+}
+
+void AlzbSerializerTest::testDesign()
+{
+    MindMapData outData;
+    outData.setBackgroundColor(QColor(1, 2, 3));
+    outData.setEdgeColor(QColor(4, 5, 6));
+    outData.setGridColor(QColor(7, 8, 9));
+    outData.setEdgeWidth(666.42);
+    outData.setTextSize(42);
+    outData.setCornerRadius(Constants::Node::DEFAULT_CORNER_RADIUS + 1);
+    outData.setAspectRatio(3.14);
+    outData.setMinEdgeLength(42.666);
+    ImageImportOptions options;
+    options.maxSize = 1024;
+    options.format = "jpg";
+    options.quality = 85;
+    outData.setImageImportOptions(options);
+    const auto inData = AlzbSerializer::fromBinary(AlzbSerializer::toBinary(outData));
+    QCOMPARE(inData->backgroundColor(), outData.backgroundColor());
+    QCOMPARE(inData->edgeColor(), outData.edgeColor());
+    QCOMPARE(inData->gridColor(), outData.gridColor());
+    QCOMPARE(inData->edgeWidth(), outData.edgeWidth());
+    QCOMPARE(inData->textSize(), outData.textSize());
+    QCOMPARE(inData->cornerRadius(), outData.cornerRadius());
+    QCOMPARE(inData->aspectRatio(), outData.aspectRatio());
+    QCOMPARE(inData->minEdgeLength(), outData.minEdgeLength());
+    QCOMPARE(inData->imageImportOptions().maxSize, options.maxSize);
+    QCOMPARE(inData->imageImportOptions().format, options.format);
+    QCOMPARE(inData->imageImportOptions().quality, options.quality);
+}
+
+void AlzbSerializerTest::testEmptyDesign()
+{
+    MindMapData outData;
+    const auto inData = AlzbSerializer::fromBinary(AlzbSerializer::toBinary(outData));
+    QCOMPARE(QString(inData->version()), QString(VERSION));
+    QCOMPARE(inData->graph().numNodes(), size_t { 0 });
+}
+
+void AlzbSerializerTest::testMagic()
+{
+    MindMapData outData;
+    QVERIFY(AlzbSerializer::isBinary(AlzbSerializer::toBinary(outData)));
+    QVERIFY(!AlzbSerializer::isBinary(AlzSerializer::toXml(outData)));
+    QVERIFY(!AlzbSerializer::isBinary({}));
+}
+
+void AlzbSerializerTest::testSingleEdge()
+{
+    MindMapData outData;
+    const auto node0 = addNode(outData, "Lorem");
+    const auto node1 = addNode(outData, "ipsum");
+    const auto edge = std::make_shared<Edge>(*node0, *node1);
+    edge->setText("dolor sit amet");
+    edge->setReversed(true);
+    edge->setArrowMode(Edge::ArrowMode::Double);
+    outData.graph().addEdge(edge);
+
+    const auto inData = AlzbSerializer::fromBinary(AlzbSerializer::toBinary(outData));
+    const auto edges = inData->graph().getEdgesFromNode(node0);
+    QCOMPARE(edges.size(), static_cast<size_t>(1));
+    QCOMPARE((*edges.begin())->text(), edge->text());
+    QCOMPARE((*edges.begin())->reversed(), edge->reversed());
+    QCOMPARE((*edges.begin())->arrowMode(), edge->arrowMode());
+}
+
+void AlzbSerializerTest::testSingleNode()
+{
+    MindMapData outData;
+    const auto outNode = addNode(outData, QString::fromUtf8("Lorem ipsum \xc3\xa4\xc3\xb6"));
+    outNode->setImageRef(1);
+
+    const auto inData = AlzbSerializer::fromBinary(AlzbSerializer::toBinary(outData));
+    QVERIFY(inData->graph().numNodes() == 1);
+
+    const auto node = inData->graph().getNode(0);
+    QCOMPARE(node->index(), outNode->index());
+    QCOMPARE(node->imageRef(), outNode->imageRef());
+    compareGraphs(outData, *inData);
+}
+
+void AlzbSerializerTest::testUsedImages()
+{
+    MindMapData outData;
+    const auto id1 = outData.imageManager().addImage(Image {});
+    const auto id2 = outData.imageManager().addImage(Image {});
+    addNode(outData, "Lorem")->setImageRef(id1);
+    addNode(outData, "ipsum")->setImageRef(id2);
+    addNode(outData, "dolor")->setImageRef(id2);
+
+    const auto binary = AlzbSerializer::toBinary(outData);
+    outData.imageManager().clear(); // ImageManager is a static class
+    QCOMPARE(outData.imageManager().images().size(), size_t { 0 });
+    const auto inData = AlzbSerializer::fromBinary(binary);
+    QCOMPARE(outData.imageManager().images().size(), size_t { 2 });
+}
+
+QTEST_GUILESS_MAIN(AlzbSerializerTest)
+
+void AlzbSerializerTest::testView()
+{
+    MindMapData outData;
+    addNode(outData, "Lorem ipsum");
+    outData.setViewRect({ -333.5, 666.25, 1024.5, 768.25 });
+
+    const auto inData = AlzbSerializer::fromBinary(AlzbSerializer::toBinary(outData));
+    QCOMPARE(inData->viewRect(), outData.viewRect());
+
+    const auto xmlData = AlzSerializer::fromXml(AlzSerializer::toXml(outData));
+    const auto convertedData = AlzbSerializer::fromBinary(AlzbSerializer::toBinary(*xmlData));
+    QCOMPARE(convertedData->viewRect(), outData.viewRect());
+
+    MindMapData noViewData;
+    QVERIFY(!AlzbSerializer::fromBinary(AlzbSerializer::toBinary(noViewData))->viewRect().isValid());
+}
@@ -0,0 +1,101 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "compression_test.hpp"
+
+#include "compressing_device.hpp"
+#include "constants.hpp"
+#include "decompressing_device.hpp"
+#include "test_mode.hpp"
+
+#include <QBuffer>
+
+CompressionTest::CompressionTest()
+{
+    TestMode::setEnabled(true);
+}
+
+static QByteArray compress(const QByteArray & data)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    CompressingDevice compressor(buffer);
+    compressor.open(QIODevice::WriteOnly);
+    // Write in uneven pieces to exercise chunking
+    for (int i = 0; i < data.size(); i += 1000) {
+        compressor.write(data.mid(i, 1000));
+    }
+    compressor.close();
+    return buffer.data();
+}
+
+void CompressionTest::testEmptyStream()
+{
+    auto compressed = compress({});
+    QVERIFY(DecompressingDevice::isCompressed(compressed));
+
+    QBuffer buffer(&compressed);
+    buffer.open(QIODevice::ReadOnly);
+    DecompressingDevice decompressor(buffer);
+    QVERIFY(decompressor.open(QIODevice::ReadOnly));
+    QVERIFY(decompressor.readAll().isEmpty());
+    QVERIFY(!decompressor.hasError());
+}
+
+void CompressionTest::testMultipleChunks()
+{
+    QByteArray data;
+    while (data.size() < 3 * Constants::Compression::CHUNK_SIZE) {
+        data += "<node index=\"" + QByteArray::number(data.size()) + "\"/>\n";
+    }
+
+    auto compressed = compress(data);
+    QVERIFY(compressed.size() < data.size() / 2);
+
+    QBuffer buffer(&compressed);
+    buffer.open(QIODevice::ReadOnly);
+    DecompressingDevice decompressor(buffer);
+    QVERIFY(decompressor.open(QIODevice::ReadOnly));
+    QCOMPARE(decompressor.readAll(), data);
+    QVERIFY(!decompressor.hasError());
+}
+
+void CompressionTest::testNotCompressed()
+{
+    QByteArray data("<?xml version=\"1.0\"?>");
+    QVERIFY(!DecompressingDevice::isCompressed(data));
+
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    DecompressingDevice decompressor(buffer);
+    QVERIFY(!decompressor.open(QIODevice::ReadOnly));
+}
+
+void CompressionTest::testTruncatedStream()
+{
+    QByteArray data(2 * Constants::Compression::CHUNK_SIZE, 'x');
+    auto compressed = compress(data);
+    compressed.chop(8);
+
+    QBuffer buffer(&compressed);
+    buffer.open(QIODevice::ReadOnly);
+    DecompressingDevice decompressor(buffer);
+    QVERIFY(decompressor.open(QIODevice::ReadOnly));
+    QVERIFY(decompressor.readAll().size() < data.size());
+    QVERIFY(decompressor.hasError());
+}
+
+QTEST_GUILESS_MAIN(CompressionTest)
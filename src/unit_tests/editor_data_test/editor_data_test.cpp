@@ -19,6 +19,12 @@
 #include "editor_data.hpp"
 #include "mind_map_data.hpp"
 #include "test_mode.hpp"
+#include "undo_command.hpp"
+#include "undo_stack.hpp"
+
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
 
 EditorDataTest::EditorDataTest()
 {
@@ -31,6 +37,7 @@ void EditorDataTest::testGroupMove()
     editorData.setMindMapData(std::make_shared<MindMapData>());
     auto node0 = editorData.addNodeAt(QPointF(0, 0));
     auto node1 = editorData.addNodeAt(QPointF(1, 1));
+    auto node2 = editorData.addNodeAt(QPointF(2, 2));
 
     editorData.toggleNodeInSelectionGroup(*node0);
     editorData.toggleNodeInSelectionGroup(*node1);
@@ -41,6 +48,8 @@ void EditorDataTest::testGroupMove()
     QCOMPARE(qFuzzyCompare(node0->location().y(), 1), true);
     QCOMPARE(qFuzzyCompare(node1->location().x(), 2), true);
     QCOMPARE(qFuzzyCompare(node1->location().y(), 2), true);
+    QCOMPARE(qFuzzyCompare(node2->location().x(), 2), true);
+    QCOMPARE(qFuzzyCompare(node2->location().y(), 2), true);
 }
 
 void EditorDataTest::testGroupSelection()
@@ -104,6 +113,32 @@ void EditorDataTest::testLoadState()
     QCOMPARE(editorData.selectedNode(), nullptr);
 }
 
+void EditorDataTest::testSaveMindMapAsync()
+{
+    QTemporaryDir dir;
+    EditorData editorData;
+    editorData.setMindMapData(std::make_shared<MindMapData>());
+    editorData.addNodeAt(QPointF(0, 0))->setText("Saved");
+
+    // A failed save is reported as well
+    QSignalSpy spy(&editorData, &EditorData::saveFinished);
+    editorData.saveMindMapAsAsync(dir.filePath("missing/test.alz"));
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.at(0).at(0).toBool(), false);
+
+    const auto fileName = dir.filePath("test.alz");
+    editorData.saveMindMapAsAsync(fileName);
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.at(1).at(0).toBool(), true);
+    QCOMPARE(editorData.fileName(), fileName);
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const auto inData = AlzSerializer::fromXml(file.readAll());
+    QCOMPARE(inData->graph().numNodes(), size_t { 1 });
+    QCOMPARE(inData->graph().getNode(0)->text(), QString("Saved"));
+}
+
 void EditorDataTest::testUndoAddNodes()
 {
     EditorData editorData;
@@ -289,6 +324,169 @@ void EditorDataTest::testUndoDeleteEdge()
     QCOMPARE(editorData.mindMapData()->graph().areDirectlyConnected(undoneNode0, undoneNode1), false);
 }
 
+void EditorDataTest::testUndoDeleteNode()
+{
+    const auto data = std::make_shared<MindMapData>();
+    EditorData editorData;
+    editorData.setMindMapData(data);
+
+    const auto node0 = editorData.addNodeAt(QPointF(0, 0));
+    const auto node1 = editorData.addNodeAt(QPointF(100, 0));
+    node1->setText("Node 1");
+    editorData.addEdge(std::make_shared<Edge>(*node0, *node1));
+    const auto index1 = node1->index();
+
+    editorData.saveUndoPoint();
+
+    editorData.deleteNode(*node1);
+
+    QCOMPARE(data->graph().numNodes(), static_cast<size_t>(1));
+    QCOMPARE(data->graph().getEdges().size(), static_cast<size_t>(0));
+
+    const auto result = editorData.undo();
+
+    // The mind map is changed in place and only the deleted items are recreated
+    QCOMPARE(editorData.mindMapData(), data);
+    QCOMPARE(result.addedNodes.size(), static_cast<size_t>(1));
+    QCOMPARE(result.addedNodes.at(0)->index(), index1);
+    QCOMPARE(result.addedEdges.size(), static_cast<size_t>(1));
+    QCOMPARE(result.designChanged, false);
+    QCOMPARE(data->graph().numNodes(), static_cast<size_t>(2));
+    QCOMPARE(data->graph().getEdges().size(), static_cast<size_t>(1));
+    QCOMPARE(editorData.getNodeByIndex(node0->index()), node0);
+    QCOMPARE(editorData.getNodeByIndex(index1)->location(), QPointF(100, 0));
+    QCOMPARE(editorData.getNodeByIndex(index1)->text(), QString("Node 1"));
+    QCOMPARE(data->graph().areDirectlyConnected(node0, editorData.getNodeByIndex(index1)), true);
+
+    editorData.redo();
+
+    QCOMPARE(data->graph().numNodes(), static_cast<size_t>(1));
+    QCOMPARE(data->graph().getEdges().size(), static_cast<size_t>(0));
+}
+
+void EditorDataTest::testUndoCommandToBytes()
+{
+    MindMapData data;
+    const auto node0 = std::make_shared<Node>();
+    data.graph().addNode(node0);
+    const auto before = MindMapState::capture(data);
+
+    const auto node1 = std::make_shared<Node>();
+    node1->setText("Node 1");
+    node1->setLocation(QPointF(100, 0));
+    data.graph().addNode(node1);
+    data.graph().addEdge(std::make_shared<Edge>(*node0, *node1));
+    node0->setText("Node 0");
+    data.setBackgroundColor(Qt::red);
+    const auto after = MindMapState::capture(data);
+
+    const auto command = UndoCommand::fromBytes(UndoCommand(before, after).toBytes());
+    QCOMPARE(command.isEmpty(), false);
+
+    command.undo(data);
+
+    QCOMPARE(data.graph().numNodes(), static_cast<size_t>(1));
+    QCOMPARE(data.graph().getEdges().size(), static_cast<size_t>(0));
+    QCOMPARE(data.graph().getNode(node0->index())->text(), QString());
+    QCOMPARE(data.backgroundColor(), before.design.backgroundColor);
+
+    command.redo(data);
+
+    QCOMPARE(data.graph().numNodes(), static_cast<size_t>(2));
+    QCOMPARE(data.graph().getEdges().size(), static_cast<size_t>(1));
+    QCOMPARE(data.graph().getNode(node0->index())->text(), QString("Node 0"));
+    QCOMPARE(data.graph().getNode(node1->index())->text(), QString("Node 1"));
+    QCOMPARE(data.graph().getNode(node1->index())->location(), QPointF(100, 0));
+    QCOMPARE(data.backgroundColor(), QColor(Qt::red));
+}
+
+void EditorDataTest::testUndoMemoryBudget()
+{
+    MindMapData data;
+    UndoStack undoStack(0, 1);
+
+    undoStack.pushUndoPoint(data);
+    data.graph().addNode(std::make_shared<Node>());
+    undoStack.pushUndoPoint(data);
+    data.graph().addNode(std::make_shared<Node>());
+
+    // Only the latest undo point fits in the budget
+    QCOMPARE(undoStack.isUndoable(), true);
+    undoStack.undo(data);
+    QCOMPARE(data.graph().numNodes(), static_cast<size_t>(1));
+    QCOMPARE(undoStack.isUndoable(), false);
+}
+
+void EditorDataTest::testUndoLog()
+{
+    QTemporaryDir dir;
+    const auto filePath = dir.filePath("test.alz");
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("mind map");
+    file.close();
+
+    MindMapData data;
+    UndoStack undoStack;
+    undoStack.pushUndoPoint(data);
+    data.graph().addNode(std::make_shared<Node>());
+    undoStack.pushUndoPoint(data);
+    data.graph().addNode(std::make_shared<Node>());
+    QVERIFY(undoStack.save(filePath, data));
+
+    // The history continues from the saved mind map
+    UndoStack loadedUndoStack;
+    QVERIFY(loadedUndoStack.load(filePath, data));
+    loadedUndoStack.undo(data);
+    QCOMPARE(data.graph().numNodes(), static_cast<size_t>(1));
+    loadedUndoStack.undo(data);
+    QCOMPARE(data.graph().numNodes(), static_cast<size_t>(0));
+    QCOMPARE(loadedUndoStack.isUndoable(), false);
+    loadedUndoStack.redo(data);
+    QCOMPARE(data.graph().numNodes(), static_cast<size_t>(1));
+
+    // A log of another version of the mind map is ignored
+    QVERIFY(file.open(QIODevice::Append));
+    file.write("changed");
+    file.close();
+    QCOMPARE(UndoStack().load(filePath, data), false);
+}
+
+void EditorDataTest::testUndoLogCorrupted()
+{
+    QTemporaryDir dir;
+    const auto filePath = dir.filePath("test.alz");
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("mind map");
+    file.close();
+
+    MindMapData data;
+    UndoStack undoStack;
+    undoStack.pushUndoPoint(data);
+    data.graph().addNode(std::make_shared<Node>());
+    undoStack.pushUndoPoint(data);
+    data.graph().addNode(std::make_shared<Node>());
+    QVERIFY(undoStack.save(filePath, data));
+
+    // The first logged command follows the magic and the version
+    QFile log(UndoLog::logPath(filePath));
+    QVERIFY(log.open(QIODevice::ReadWrite));
+    QVERIFY(log.seek(8 + sizeof(quint32)));
+    log.write("X");
+    log.close();
+
+    // The history ends at the command that can't be read
+    UndoStack loadedUndoStack;
+    QVERIFY(loadedUndoStack.load(filePath, data));
+    QCOMPARE(loadedUndoStack.isUndoable(), true);
+    loadedUndoStack.undo(data);
+    QCOMPARE(data.graph().numNodes(), static_cast<size_t>(1));
+    QCOMPARE(loadedUndoStack.isUndoable(), false);
+    loadedUndoStack.redo(data);
+    QCOMPARE(data.graph().numNodes(), static_cast<size_t>(2));
+}
+
 void EditorDataTest::testUndoBackgroundColor()
 {
     EditorData editorData;
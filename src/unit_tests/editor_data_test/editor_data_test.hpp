@@ -30,6 +30,8 @@ private slots:
 
     void testLoadState();
 
+    void testSaveMindMapAsync();
+
     void testUndoAddNodes();
 
     void testRedoAddNodes();
@@ -42,6 +44,16 @@ private slots:
 
     void testUndoDeleteEdge();
 
+    void testUndoDeleteNode();
+
+    void testUndoCommandToBytes();
+
+    void testUndoMemoryBudget();
+
+    void testUndoLog();
+
+    void testUndoLogCorrupted();
+
     void testUndoBackgroundColor();
 
     void testUndoCornerRadius();
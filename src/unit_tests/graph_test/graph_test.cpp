@@ -288,4 +288,90 @@ void GraphTest::testGetNodeByIndex_NotFound()
     QVERIFY(message == "Invalid node index: " + std::to_string(666));
 }
 
+void GraphTest::testReplace()
+{
+    Graph dut;
+    const auto node0 = make_shared<Node>();
+    dut.addNode(node0);
+    const auto node1 = make_shared<Node>();
+    dut.addNode(node1);
+    dut.addEdge(make_shared<Edge>(*node0, *node1));
+
+    const auto node2 = make_shared<Node>();
+    node2->setIndex(5);
+    node2->setLocation({ 1000, 0 });
+    const auto edge = make_shared<Edge>(*node1, *node2);
+    dut.replace({ node1, node2 }, { edge });
+
+    QCOMPARE(dut.numNodes(), size_t(2));
+    QCOMPARE(dut.getNode(5), node2);
+    QCOMPARE(dut.getEdges(), Graph::EdgeVector { edge });
+    QCOMPARE(dut.spatialIndex().size(), size_t(2));
+    QCOMPARE(dut.spatialIndex().intersecting({ 999, -1, 2, 2 }), std::vector<Node *> { node2.get() });
+
+    // New nodes get indices after the replaced ones
+    const auto node3 = make_shared<Node>();
+    dut.addNode(node3);
+    QCOMPARE(node3->index(), 6);
+}
+
+void GraphTest::testSpatialIndex()
+{
+    Graph dut;
+    const auto node0 = make_shared<Node>();
+    node0->setLocation({ 0, 0 });
+    dut.addNode(node0);
+    const auto node1 = make_shared<Node>();
+    node1->setLocation({ 1000, 0 });
+    dut.addNode(node1);
+    const auto node2 = make_shared<Node>();
+    node2->setLocation({ 0, 1000 });
+    dut.addNode(node2);
+
+    auto && index = dut.spatialIndex();
+    QCOMPARE(index.size(), size_t(3));
+    QCOMPARE(index.intersecting({ -1, -1, 2, 2 }), std::vector<Node *> { node0.get() });
+    QCOMPARE(index.contained({ -1, -1, 2, 2 }).empty(), true);
+    QCOMPARE(index.contained({ 500, -500, 1000, 1000 }), std::vector<Node *> { node1.get() });
+    QCOMPARE(index.nearest({ 400, 900 }), node2.get());
+
+    node2->setLocation({ 5000, 5000 });
+    QCOMPARE(index.intersecting({ -1, 999, 2, 2 }).empty(), true);
+    QCOMPARE(index.intersecting({ 4999, 4999, 2, 2 }), std::vector<Node *> { node2.get() });
+    QCOMPARE(index.nearest({ 400, 900 }), node0.get());
+
+    dut.deleteNode(node0->index());
+    QCOMPARE(index.size(), size_t(2));
+    QCOMPARE(index.intersecting({ -1, -1, 2, 2 }).empty(), true);
+    QCOMPARE(index.nearest({ 400, 900 }), node1.get());
+}
+
+void GraphTest::testSpatialIndexBounds()
+{
+    Graph dut;
+    auto && index = dut.spatialIndex();
+    QCOMPARE(index.bounds().isNull(), true);
+
+    const auto node0 = make_shared<Node>();
+    dut.addNode(node0);
+    const auto node1 = make_shared<Node>();
+    node1->setLocation({ 1000, 500 });
+    dut.addNode(node1);
+
+    const auto width = node0->size().width();
+    const auto height = node0->size().height();
+    QCOMPARE(index.bounds(), QRectF(-width / 2, -height / 2, 1000 + width, 500 + height));
+    QCOMPARE(index.nodeArea(), 2 * width * height);
+
+    node1->setLocation({ 2000, 500 });
+    QCOMPARE(index.bounds(), QRectF(-width / 2, -height / 2, 2000 + width, 500 + height));
+
+    node1->setLocation({ 100, 0 });
+    QCOMPARE(index.bounds(), QRectF(-width / 2, -height / 2, 100 + width, height));
+
+    dut.deleteNode(node1->index());
+    QCOMPARE(index.bounds(), QRectF(-width / 2, -height / 2, width, height));
+    QCOMPARE(index.nodeArea(), width * height);
+}
+
 QTEST_GUILESS_MAIN(GraphTest)
@@ -47,4 +47,10 @@ private slots:
     void testGetNodeByIndex();
 
     void testGetNodeByIndex_NotFound();
+
+    void testReplace();
+
+    void testSpatialIndex();
+
+    void testSpatialIndexBounds();
 };
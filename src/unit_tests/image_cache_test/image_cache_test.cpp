@@ -0,0 +1,101 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "image_cache_test.hpp"
+
+#include "image.hpp"
+#include "image_cache.hpp"
+#include "test_mode.hpp"
+
+#include <QBuffer>
+#include <QImage>
+#include <QImageWriter>
+
+#include <limits>
+
+ImageCacheTest::ImageCacheTest()
+{
+    TestMode::setEnabled(true);
+}
+
+static Image createImage(QSize size, QColor color, const char * format = "PNG")
+{
+    QImage image(size, QImage::Format_RGB32);
+    image.fill(color);
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, format);
+    return { data, "" };
+}
+
+void ImageCacheTest::testEviction()
+{
+    ImageCache cache;
+    const auto image0 = createImage({ 256, 128 }, Qt::red);
+    const auto image1 = createImage({ 256, 128 }, Qt::green);
+
+    cache.setBudget(std::numeric_limits<qint64>::max());
+    const auto cost = [](const QPixmap & pixmap) {
+        return static_cast<qint64>(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+    };
+    const auto pixmap0 = cache.pixmap(image0, { 256, 128 });
+    QCOMPARE(cache.usage(), cost(pixmap0));
+
+    // Room for one full-size image only, so the least recently used one goes
+    cache.setBudget(cost(pixmap0));
+    const auto pixmap1 = cache.pixmap(image1, { 256, 128 });
+    QCOMPARE(cache.usage(), cost(pixmap1));
+
+    // Smaller mip levels are separate entries
+    const auto pixmap2 = cache.pixmap(image1, { 64, 32 });
+    QCOMPARE(pixmap2.size(), QSize(64, 32));
+    QCOMPARE(cache.usage(), cost(pixmap2));
+
+    // The most recently used entry is kept even if it alone exceeds the budget
+    cache.setBudget(1);
+    QCOMPARE(cache.usage(), cost(pixmap2));
+
+    cache.clear();
+    QCOMPARE(cache.usage(), qint64(0));
+}
+
+void ImageCacheTest::testMipLevel()
+{
+    ImageCache cache;
+    cache.setBudget(std::numeric_limits<qint64>::max());
+    const auto image = createImage({ 256, 128 }, Qt::red);
+
+    QCOMPARE(cache.pixmap(image, { 512, 512 }).size(), QSize(256, 128));
+    QCOMPARE(cache.pixmap(image, { 256, 128 }).size(), QSize(256, 128));
+    QCOMPARE(cache.pixmap(image, { 129, 64 }).size(), QSize(256, 128));
+    QCOMPARE(cache.pixmap(image, { 128, 64 }).size(), QSize(128, 64));
+    QCOMPARE(cache.pixmap(image, { 100, 10 }).size(), QSize(128, 64));
+    QCOMPARE(cache.pixmap(image, { 1, 1 }).size(), QSize(2, 1));
+}
+
+void ImageCacheTest::testSizeFromDecodedImage()
+{
+    // The XPM reader can't tell the size without decoding the image
+    QVERIFY(QImageWriter::supportedImageFormats().contains("xpm"));
+    const auto image = createImage({ 64, 32 }, Qt::blue, "XPM");
+
+    ImageCache cache;
+    cache.setBudget(std::numeric_limits<qint64>::max());
+    QCOMPARE(cache.pixmap(image, { 64, 32 }).size(), QSize(64, 32));
+    QCOMPARE(cache.pixmap(image, { 32, 16 }).size(), QSize(32, 16));
+}
+
+QTEST_MAIN(ImageCacheTest)
@@ -94,6 +94,23 @@ void SerializerTest::testNotUsedImages()
     QCOMPARE(outData.imageManager().images().size(), size_t { 0 });
 }
 
+void SerializerTest::testUnknownElements()
+{
+    const QByteArray xml = "<design version=\"1.0\">"
+                           "<unknown/>"
+                           "<graph>"
+                           "<node index=\"0\" x=\"0\" y=\"0\"><unknown><text>Foo</text></unknown><text>Bar</text></node>"
+                           "<unknown/>"
+                           "</graph>"
+                           "<text-size>42000</text-size>"
+                           "</design>";
+
+    const auto inData = AlzSerializer::fromXml(xml);
+    QCOMPARE(inData->graph().getNodes().size(), static_cast<size_t>(1));
+    QCOMPARE(inData->graph().getNode(0)->text(), QString("Bar"));
+    QCOMPARE(inData->textSize(), 42);
+}
+
 void SerializerTest::testUsedImages()
 {
     MindMapData outData;
@@ -121,6 +138,17 @@ void SerializerTest::testTextSize()
     QCOMPARE(inData->textSize(), outData.textSize());
 }
 
+void SerializerTest::testViewRect()
+{
+    MindMapData outData;
+    auto inData = AlzSerializer::fromXml(AlzSerializer::toXml(outData));
+    QVERIFY(!inData->viewRect().isValid());
+
+    outData.setViewRect({ -100.5, 200, 640, 480 });
+    inData = AlzSerializer::fromXml(AlzSerializer::toXml(outData));
+    QCOMPARE(inData->viewRect(), outData.viewRect());
+}
+
 void SerializerTest::testNodeDeletion()
 {
     MindMapData outData;
@@ -145,6 +173,103 @@ void SerializerTest::testNodeDeletion()
     QCOMPARE(edges.size(), static_cast<size_t>(1));
 }
 
+void SerializerTest::testImageData()
+{
+    MindMapData outData;
+    Image image;
+    image.setData("Lorem ipsum");
+    const auto id = outData.imageManager().addImage(image);
+    auto node = std::make_shared<Node>();
+    outData.graph().addNode(node);
+    node->setImageRef(id);
+
+    const auto outXml = AlzSerializer::toXml(outData);
+    outData.imageManager().clear(); // ImageManager is a static class
+    const auto inData = AlzSerializer::fromXml(outXml);
+    const auto images = outData.imageManager().images();
+    QCOMPARE(images.size(), size_t { 1 });
+    QCOMPARE(images.at(0).data(), image.data());
+    QCOMPARE(images.at(0).hash(), image.hash());
+}
+
+void SerializerTest::testImageImportOptions()
+{
+    MindMapData outData;
+    ImageImportOptions options;
+    options.maxSize = 1024;
+    options.format = "jpg";
+    options.quality = 85;
+    outData.setImageImportOptions(options);
+    const auto inData = AlzSerializer::fromXml(AlzSerializer::toXml(outData));
+    QCOMPARE(inData->imageImportOptions().maxSize, options.maxSize);
+    QCOMPARE(inData->imageImportOptions().format, options.format);
+    QCOMPARE(inData->imageImportOptions().quality, options.quality);
+}
+
+void SerializerTest::testParallelParsing()
+{
+    MindMapData outData;
+    outData.setTextSize(42);
+    outData.setMinEdgeLength(123);
+    const int nodeCount = 100;
+    for (int i = 0; i < nodeCount; i++) {
+        auto node = std::make_shared<Node>();
+        node->setLocation(QPointF(i, -i));
+        node->setText(QString("Node %1").arg(i));
+        outData.graph().addNode(node);
+        if (i) {
+            const auto edge = std::make_shared<Edge>(*outData.graph().getNode(i - 1), *node);
+            edge->setText(QString("Edge %1").arg(i));
+            outData.graph().addEdge(edge);
+        }
+    }
+
+    const auto outXml = AlzSerializer::toXml(outData);
+    const auto inData = AlzSerializer::fromXmlParallel(outXml, 256);
+    const auto refData = AlzSerializer::fromXml(outXml);
+    QCOMPARE(inData->textSize(), 42);
+    QCOMPARE(inData->minEdgeLength(), 123.0);
+    QCOMPARE(inData->graph().getNodes().size(), refData->graph().getNodes().size());
+    QCOMPARE(inData->graph().getEdges().size(), refData->graph().getEdges().size());
+    for (int i = 0; i < nodeCount; i++) {
+        QCOMPARE(inData->graph().getNode(i)->location(), refData->graph().getNode(i)->location());
+        QCOMPARE(inData->graph().getNode(i)->text(), refData->graph().getNode(i)->text());
+    }
+    for (size_t i = 0; i < refData->graph().getEdges().size(); i++) {
+        const auto inEdge = inData->graph().getEdges().at(i);
+        const auto refEdge = refData->graph().getEdges().at(i);
+        QCOMPARE(inEdge->sourceNode().index(), refEdge->sourceNode().index());
+        QCOMPARE(inEdge->targetNode().index(), refEdge->targetNode().index());
+        QCOMPARE(inEdge->text(), refEdge->text());
+    }
+
+    QVERIFY_EXCEPTION_THROWN(AlzSerializer::fromXmlParallel(outXml.left(outXml.size() / 2), 256), std::runtime_error);
+}
+
+void SerializerTest::testSharedImages()
+{
+    MindMapData outData;
+    Image image;
+    image.setData("Lorem ipsum");
+    const auto id1 = outData.imageManager().addImage(image);
+    const auto id2 = outData.imageManager().addImage(image);
+    QCOMPARE(id1, id2);
+    QCOMPARE(outData.imageManager().images().size(), size_t { 1 });
+
+    for (int i = 0; i < 3; i++) {
+        auto node = std::make_shared<Node>();
+        outData.graph().addNode(node);
+        node->setImageRef(id1);
+    }
+
+    const auto outXml = AlzSerializer::toXml(outData);
+    QCOMPARE(outXml.count("<image id="), 1);
+    outData.imageManager().clear(); // ImageManager is a static class
+    const auto inData = AlzSerializer::fromXml(outXml);
+    QCOMPARE(outData.imageManager().images().size(), size_t { 1 });
+    QCOMPARE(inData->graph().getNode(2)->imageRef(), id1);
+}
+
 void SerializerTest::testSingleEdge()
 {
     MindMapData outData;
@@ -170,6 +295,26 @@ void SerializerTest::testSingleEdge()
     QCOMPARE((*edges.begin())->arrowMode(), edge->arrowMode());
 }
 
+void SerializerTest::testSavedNodeSize()
+{
+    MindMapData outData;
+
+    const auto outNode = std::make_shared<Node>();
+    outNode->setText("Lorem ipsum");
+    outNode->setSize(QSizeF(123, 321));
+    outData.graph().addNode(outNode);
+
+    // The text is not laid out again on load
+    const auto outXml = AlzSerializer::toXml(outData);
+    const auto inData = AlzSerializer::fromXml(outXml);
+    QCOMPARE(inData->graph().getNode(0)->size(), QSizeF(123, 321));
+    QCOMPARE(inData->graph().getNode(0)->text(), QString("Lorem ipsum"));
+
+    const auto parallelInData = AlzSerializer::fromXmlParallel(outXml, 1);
+    QCOMPARE(parallelInData->graph().getNode(0)->size(), QSizeF(123, 321));
+    QCOMPARE(parallelInData->graph().getNode(0)->text(), QString("Lorem ipsum"));
+}
+
 void SerializerTest::testSingleNode()
 {
     MindMapData outData;
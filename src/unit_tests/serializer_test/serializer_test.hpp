@@ -36,17 +36,31 @@ private slots:
 
     void testEdgeWidth();
 
+    void testImageData();
+
+    void testImageImportOptions();
+
     void testLayoutOptimizer();
 
     void testNotUsedImages();
 
     void testNodeDeletion();
 
+    void testParallelParsing();
+
+    void testSavedNodeSize();
+
+    void testSharedImages();
+
     void testSingleEdge();
 
     void testSingleNode();
 
     void testTextSize();
 
+    void testUnknownElements();
+
     void testUsedImages();
+
+    void testViewRect();
 };
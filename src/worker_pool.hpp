@@ -0,0 +1,67 @@
+// This file is part of Heimer.
+// Copyright (C) 2020 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <QRunnable>
+#include <QThreadPool>
+
+#include <functional>
+#include <future>
+#include <memory>
+
+//! Thin wrapper around QThreadPool that hands results back through std::future.
+//! Exceptions thrown by a job are rethrown from future::get().
+namespace WorkerPool {
+
+class Job : public QRunnable
+{
+public:
+    explicit Job(std::function<void()> function)
+      : m_function(function)
+    {
+    }
+
+    void run() override
+    {
+        m_function();
+    }
+
+private:
+    std::function<void()> m_function;
+};
+
+//! Jobs that wait for other jobs on the global pool (e.g. a save that compresses in parallel) must be run
+//! on a pool of their own. Otherwise they could take all the threads of the global pool and never finish.
+template<typename Function>
+auto run(QThreadPool & pool, Function function) -> std::future<decltype(function())>
+{
+    using Result = decltype(function());
+    const auto task = std::make_shared<std::packaged_task<Result()>>(function);
+    auto future = task->get_future();
+    pool.start(new Job([task] { (*task)(); }));
+    return future;
+}
+
+template<typename Function>
+auto run(Function function) -> std::future<decltype(function())>
+{
+    return run(*QThreadPool::globalInstance(), function);
+}
+
+} // namespace WorkerPool
+
+#endif // WORKER_POOL_HPP
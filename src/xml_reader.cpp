@@ -15,25 +15,104 @@
 
 #include "xml_reader.hpp"
 
+#include "constants.hpp"
+#include "decompressing_device.hpp"
+#include "simple_logger.hpp"
+
+#include <QByteArray>
 #include <QFile>
 #include <QObject>
 
-QDomDocument XmlReader::readFromFile(QString filePath)
+#include <limits>
+
+namespace XmlReader {
+
+static void parse(QXmlStreamReader & reader, StreamHandler handler, QString filePath)
+{
+    handler(reader);
+
+    if (reader.hasError()) {
+        juzzlin::L().error() << "XML error at line " << reader.lineNumber() << ": " << reader.errorString().toStdString();
+        throw FileException(QObject::tr("Corrupted file: '") + filePath + "'");
+    }
+}
+
+static bool isCompressed(QFile & file)
 {
-    QDomDocument doc;
+    return DecompressingDevice::isCompressed(file.peek(Constants::Compression::MAGIC_SIZE));
+}
 
+void readFromFile(QString filePath, StreamHandler handler)
+{
     QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly)) {
         throw FileException(QObject::tr("Cannot open file: '") + filePath + "'");
     }
 
-    if (!doc.setContent(&file)) {
-        file.close();
+    if (isCompressed(file)) {
+        // Chunks are inflated on the worker pool ahead of the parser
+        DecompressingDevice device(file);
+        device.open(QIODevice::ReadOnly);
+        QXmlStreamReader reader(&device);
+        parse(reader, handler, filePath);
+        return;
+    }
 
-        throw FileException(QObject::tr("Corrupted file: '") + filePath + "'");
+    const auto size = file.size();
+    const auto data = size > 0 && size <= std::numeric_limits<int>::max() ? file.map(0, size) : nullptr;
+    if (data) {
+        // The mapping stays valid until the file is unmapped or closed, which outlives the parser
+        QXmlStreamReader reader(QByteArray::fromRawData(reinterpret_cast<const char *>(data), static_cast<int>(size)));
+        parse(reader, handler, filePath);
+        file.unmap(data);
+    } else {
+        QXmlStreamReader reader(&file);
+        parse(reader, handler, filePath);
     }
 
     file.close();
+}
 
-    return doc;
+static void handleData(const QByteArray & data, DataHandler handler, QString filePath)
+{
+    try {
+        handler(data);
+    } catch (const FileException &) {
+        throw;
+    } catch (const std::runtime_error & e) {
+        juzzlin::L().error() << e.what();
+        throw FileException(QObject::tr("Corrupted file: '") + filePath + "'");
+    }
 }
+
+void mapFile(QString filePath, DataHandler handler)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw FileException(QObject::tr("Cannot open file: '") + filePath + "'");
+    }
+
+    if (isCompressed(file)) {
+        DecompressingDevice device(file);
+        device.open(QIODevice::ReadOnly);
+        const auto xml = device.readAll();
+        if (device.hasError()) {
+            throw FileException(QObject::tr("Corrupted file: '") + filePath + "'");
+        }
+        handleData(xml, handler, filePath);
+        return;
+    }
+
+    const auto size = file.size();
+    const auto data = size > 0 && size <= std::numeric_limits<int>::max() ? file.map(0, size) : nullptr;
+    if (data) {
+        handleData(QByteArray::fromRawData(reinterpret_cast<const char *>(data), static_cast<int>(size)), handler, filePath);
+        file.unmap(data);
+    } else {
+        handleData(file.readAll(), handler, filePath);
+    }
+
+    file.close();
+}
+
+} // namespace XmlReader
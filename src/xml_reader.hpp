@@ -16,14 +16,28 @@
 #ifndef XML_READER_HPP
 #define XML_READER_HPP
 
-#include <QDomDocument>
+#include <QByteArray>
+#include <QXmlStreamReader>
+
+#include <functional>
 
 #include "file_exception.hpp"
 
 namespace XmlReader {
 
-QDomDocument readFromFile(QString filePath);
+using StreamHandler = std::function<void(QXmlStreamReader &)>;
+
+//! Runs the given pull parser handler over the file. The file is memory-mapped when possible
+//! so that no intermediate copy of the content is made. Compressed files are inflated while
+//! being parsed. Throws FileException on failure.
+void readFromFile(QString filePath, StreamHandler handler);
+
+using DataHandler = std::function<void(const QByteArray &)>;
+
+//! Passes the whole (decompressed) content to the handler, memory-mapped when possible. Throws FileException
+//! on failure, including a std::runtime_error thrown by the handler on malformed content.
+void mapFile(QString filePath, DataHandler handler);
 
-}
+} // namespace XmlReader
 
 #endif // XML_READER_HPP
@@ -15,17 +15,31 @@
 
 #include "xml_writer.hpp"
 
-#include <QFile>
-#include <QTextStream>
+#include "compressing_device.hpp"
+#include "simple_logger.hpp"
 
-bool XmlWriter::writeToFile(QDomDocument document, QString filePath)
+#include <QSaveFile>
+
+bool XmlWriter::writeToFile(QString filePath, StreamHandler handler, bool compress)
 {
-    QFile file(filePath);
-    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QTextStream out(&file);
-        out << document;
-        file.close();
-        return true;
+    QSaveFile file(filePath);
+    if (file.open(compress ? QIODevice::WriteOnly : QIODevice::WriteOnly | QIODevice::Text)) {
+        CompressingDevice compressor(file);
+        if (compress && !compressor.open(QIODevice::WriteOnly)) {
+            juzzlin::L().error() << "Cannot write file '" << filePath.toStdString() << "': " << file.errorString().toStdString();
+            file.cancelWriting();
+            return false;
+        }
+        QXmlStreamWriter writer(compress ? static_cast<QIODevice *>(&compressor) : &file);
+        writer.setAutoFormatting(true);
+        handler(writer);
+        compressor.close();
+        if (writer.hasError() || compressor.hasError()) {
+            juzzlin::L().error() << "Cannot write file '" << filePath.toStdString() << "': " << file.errorString().toStdString();
+            file.cancelWriting();
+            return false;
+        }
+        return file.commit();
     }
 
     return false;
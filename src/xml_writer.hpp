@@ -16,11 +16,18 @@
 #ifndef XML_WRITER_HPP
 #define XML_WRITER_HPP
 
-#include <QDomDocument>
+#include <QXmlStreamWriter>
+
+#include <functional>
 
 namespace XmlWriter {
 
-bool writeToFile(QDomDocument document, QString filePath);
+using StreamHandler = std::function<void(QXmlStreamWriter &)>;
+
+//! Runs the given handler against a writer on a buffered QSaveFile. The target file is
+//! replaced atomically only if everything was written successfully. If compress is true,
+//! the document is deflated in chunks on the worker pool while it's being written.
+bool writeToFile(QString filePath, StreamHandler handler, bool compress = false);
 }
 
 #endif // XML_WRITER_HPP